@@ -0,0 +1,92 @@
+# Compiles a source file in debug and optimized configurations, and reports the build time and the size of the
+# object file of each configuration. Each configuration is compiled REPEAT times and the fastest build is
+# reported.
+#
+# Required variables:
+#   COMPILER      The C++ compiler.
+#   COMPILER_ID   The value of CMAKE_CXX_COMPILER_ID.
+#   SOURCE        The source file.
+#   INCLUDE_DIR   The include directory of the library.
+#   OUTPUT_DIR    The directory for object files.
+# Optional variables:
+#   REPEAT        The number of builds of each configuration. Defaults to 3.
+#   MAX_SECONDS   Fail if the debug build takes longer than this. Fractions such as 1.5 are accepted, and are
+#                 compared with microsecond precision.
+#   MAX_BYTES     Fail if the debug object file is larger than this.
+
+cmake_minimum_required(VERSION 3.23) # string(TIMESTAMP) with microseconds
+
+if(NOT DEFINED REPEAT)
+	set(REPEAT 3)
+endif()
+if(DEFINED MAX_SECONDS AND NOT MAX_SECONDS STREQUAL "")
+	# math(EXPR) only supports integers, so convert the limit to microseconds textually
+	if(NOT MAX_SECONDS MATCHES "^([0-9]*)(\\.([0-9]*))?$" OR MAX_SECONDS STREQUAL ".")
+		message(FATAL_ERROR "MAX_SECONDS must be a non-negative decimal number, got '${MAX_SECONDS}'")
+	endif()
+	set(whole "${CMAKE_MATCH_1}")
+	string(SUBSTRING "${CMAKE_MATCH_3}000000" 0 6 fraction)
+	if(whole STREQUAL "")
+		set(whole 0)
+	endif()
+	string(REGEX REPLACE "^0+([0-9])" "\\1" fraction "${fraction}")
+	math(EXPR max_microseconds "${whole} * 1000000 + ${fraction}")
+endif()
+
+if(COMPILER_ID STREQUAL "MSVC")
+	set(common_flags /nologo /std:c++17 /permissive- /EHsc /c "/I${INCLUDE_DIR}" "${SOURCE}")
+	set(debug_flags /Od /Z7)
+	set(release_flags /O2)
+	set(output_flag "/Fo")
+	set(object_suffix ".obj")
+else()
+	set(common_flags -std=c++17 -c "-I${INCLUDE_DIR}" "${SOURCE}")
+	set(debug_flags -O0 -g)
+	set(release_flags -O2)
+	set(output_flag "-o")
+	set(object_suffix ".o")
+endif()
+
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+foreach(config debug release)
+	set(object "${OUTPUT_DIR}/compile_time_${config}${object_suffix}")
+	if(COMPILER_ID STREQUAL "MSVC")
+		set(output_args "${output_flag}${object}")
+	else()
+		set(output_args ${output_flag} "${object}")
+	endif()
+
+	set(best "")
+	foreach(i RANGE 1 ${REPEAT})
+		string(TIMESTAMP begin "%s%f" UTC)
+		execute_process(
+			COMMAND "${COMPILER}" ${${config}_flags} ${common_flags} ${output_args}
+			RESULT_VARIABLE result
+		)
+		string(TIMESTAMP end "%s%f" UTC)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "Failed to compile ${SOURCE}")
+		endif()
+		math(EXPR elapsed "${end} - ${begin}")
+		if(best STREQUAL "" OR elapsed LESS best)
+			set(best ${elapsed})
+		endif()
+	endforeach()
+
+	file(SIZE "${object}" size)
+	math(EXPR milliseconds "${best} / 1000")
+	message(STATUS "${config}: ${milliseconds} ms, ${size} bytes")
+	set(${config}_microseconds ${best})
+	set(${config}_size ${size})
+endforeach()
+
+if(DEFINED max_microseconds)
+	if(debug_microseconds GREATER max_microseconds)
+		message(FATAL_ERROR "The debug build took longer than ${MAX_SECONDS} s")
+	endif()
+endif()
+if(DEFINED MAX_BYTES AND NOT MAX_BYTES STREQUAL "")
+	if(debug_size GREATER MAX_BYTES)
+		message(FATAL_ERROR "The debug object file is larger than ${MAX_BYTES} bytes")
+	endif()
+endif()
@@ -0,0 +1,62 @@
+/// \file
+/// A synthetic translation unit that uses \ref math::vec and \ref math::point heavily, for measuring build times
+/// and object sizes. It is only compiled, never linked or run.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <cgmath/vec.h>
+#include <cgmath/point.h>
+
+using namespace math;
+
+/// Uses all element-wise operations of vectors and points with the given type and dimension.
+template <typename T, std::size_t Dim> T exercise(const T *in) {
+	vec<T, Dim> a, b;
+	point<T, Dim> p;
+	for (std::size_t d = 0; d < Dim; ++d) {
+		a[d] = in[d];
+		b[d] = in[Dim + d];
+		p[d] = in[2 * Dim + d];
+	}
+
+	vec<T, Dim> c = a + b;
+	c -= a;
+	c += b;
+	c = c * in[0];
+	c = in[1] * c;
+	c *= in[2];
+	c = c / in[3];
+	c /= in[4];
+	c = -c;
+	point<T, Dim> q = p + c;
+	q -= a;
+	q += b;
+	vec<T, Dim> e = q - p;
+
+	T result = vec<T, Dim>::dot(a, b) + e.squared_norm();
+	if constexpr (std::is_integral_v<T>) {
+		result += static_cast<T>((a == b) + (a != c) + (p == q));
+	} else {
+		result += a.norm();
+		result += a.normalized_nocheck().result[0];
+	}
+	vec<T, 3> s = a.template swizzle<0, Dim - 1, 0>();
+	return result + s[1];
+}
+
+/// Calls \ref exercise() for all dimensions in the sequence.
+template <typename T, std::size_t ...Dims> T exercise_all(const T *in, std::index_sequence<Dims...>) {
+	return (exercise<T, Dims + 1>(in) + ...);
+}
+
+/// The entry point that instantiates everything.
+double exercise_everything(const void *in) {
+	using dims = std::make_index_sequence<8>;
+	return
+		static_cast<double>(exercise_all(static_cast<const float*>(in), dims{})) +
+		static_cast<double>(exercise_all(static_cast<const double*>(in), dims{})) +
+		static_cast<double>(exercise_all(static_cast<const int*>(in), dims{})) +
+		static_cast<double>(exercise_all(static_cast<const std::size_t*>(in), dims{}));
+}
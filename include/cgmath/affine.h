@@ -0,0 +1,440 @@
+#pragma once
+
+/// \file
+/// Affine and rigid transformations.
+
+#include <algorithm>
+#include <cmath>
+
+#include "array.h"
+#include "arithmetic.h"
+#include "vec.h"
+#include "point.h"
+#include "soa.h"
+#include "instrument.h"
+
+namespace math {
+	template <typename, std::size_t> struct rigid;
+
+	/// An affine transformation stored as a \p Dim x (\p Dim + 1) row-major matrix. The first \p Dim columns hold
+	/// the linear part and the last column holds the translation; the implicit last row of the homogeneous matrix
+	/// is not stored. Translation only applies to \ref point objects.
+	template <typename T, std::size_t Dim> struct affine : public array<T, Dim, Dim + 1> {
+		friend rigid<T, Dim>;
+	public:
+		/// Default constructor. All elements are zero-initialized.
+		constexpr affine() = default;
+		/// Implicit conversion from rigid transformations.
+		constexpr affine(const rigid<T, Dim>&);
+
+		/// Returns the identity transformation.
+		[[nodiscard]] constexpr static affine identity() {
+			affine result;
+			for (std::size_t i = 0; i < Dim; ++i) {
+				result[i][i] = static_cast<T>(1);
+			}
+			return result;
+		}
+		/// Returns a translation.
+		[[nodiscard]] constexpr static affine translation(const vec<T, Dim> &offset) {
+			affine result = identity();
+			result.set_translation(offset);
+			return result;
+		}
+		/// Returns a non-uniform scaling.
+		[[nodiscard]] constexpr static affine scaling(const vec<T, Dim> &scale) {
+			affine result;
+			for (std::size_t i = 0; i < Dim; ++i) {
+				result[i][i] = scale[i];
+			}
+			return result;
+		}
+		/// Creates a transformation from its linear part and its translation.
+		[[nodiscard]] constexpr static affine from_linear(
+			const array<T, Dim, Dim> &linear, const vec<T, Dim> &offset
+		) {
+			affine result;
+			for (std::size_t r = 0; r < Dim; ++r) {
+				for (std::size_t c = 0; c < Dim; ++c) {
+					result[r][c] = linear[r][c];
+				}
+			}
+			result.set_translation(offset);
+			return result;
+		}
+
+		/// Returns the translation of this transformation.
+		[[nodiscard]] constexpr vec<T, Dim> get_translation() const {
+			vec<T, Dim> result;
+			for (std::size_t i = 0; i < Dim; ++i) {
+				result[i] = (*this)[i][Dim];
+			}
+			return result;
+		}
+		/// Sets the translation of this transformation.
+		constexpr void set_translation(const vec<T, Dim> &offset) {
+			for (std::size_t i = 0; i < Dim; ++i) {
+				(*this)[i][Dim] = offset[i];
+			}
+		}
+
+		/// Transforms a point. Translation is applied.
+		[[nodiscard]] constexpr point<T, Dim> transform(const point<T, Dim> &p) const {
+			point<T, Dim> result;
+			for (std::size_t r = 0; r < Dim; ++r) {
+				T sum = (*this)[r][Dim];
+				for (std::size_t c = 0; c < Dim; ++c) {
+					sum += (*this)[r][c] * p[c];
+				}
+				result[r] = sum;
+			}
+			return result;
+		}
+		/// Transforms a vector. Translation is ignored.
+		[[nodiscard]] constexpr vec<T, Dim> transform(const vec<T, Dim> &v) const {
+			vec<T, Dim> result;
+			for (std::size_t r = 0; r < Dim; ++r) {
+				T sum{};
+				for (std::size_t c = 0; c < Dim; ++c) {
+					sum += (*this)[r][c] * v[c];
+				}
+				result[r] = sum;
+			}
+			return result;
+		}
+		/// Transforms a unit vector. The result is not necessarily a unit vector.
+		[[nodiscard]] constexpr vec<T, Dim> transform(const unit_vec<T, Dim> &v) const {
+			return transform(vec<T, Dim>(v));
+		}
+		/// Composes two transformations. The resulting transformation applies \p rhs first, then \p this.
+		[[nodiscard]] constexpr affine transform(const affine &rhs) const {
+			affine result;
+			for (std::size_t r = 0; r < Dim; ++r) {
+				for (std::size_t c = 0; c <= Dim; ++c) {
+					T sum = c == Dim ? (*this)[r][Dim] : T{};
+					for (std::size_t k = 0; k < Dim; ++k) {
+						sum += (*this)[r][k] * rhs[k][c];
+					}
+					result[r][c] = sum;
+				}
+			}
+			return result;
+		}
+
+		/// Returns the inverse of this transformation, computed using Gauss-Jordan elimination with partial
+		/// pivoting. The transformation must be invertible.
+		[[nodiscard]] constexpr affine inverse() const {
+			affine work = *this, result = identity();
+			for (std::size_t c = 0; c < Dim; ++c) {
+				std::size_t pivot = c;
+				for (std::size_t r = c + 1; r < Dim; ++r) {
+					if (_abs(work[r][c]) > _abs(work[pivot][c])) {
+						pivot = r;
+					}
+				}
+				if (pivot != c) {
+					for (std::size_t k = 0; k <= Dim; ++k) {
+						_swap(work[c][k], work[pivot][k]);
+						_swap(result[c][k], result[pivot][k]);
+					}
+				}
+				T inv_pivot = static_cast<T>(1) / work[c][c];
+				for (std::size_t k = 0; k <= Dim; ++k) {
+					work[c][k] *= inv_pivot;
+					result[c][k] *= inv_pivot;
+				}
+				for (std::size_t r = 0; r < Dim; ++r) {
+					if (r != c) {
+						T factor = work[r][c];
+						for (std::size_t k = 0; k <= Dim; ++k) {
+							work[r][k] -= factor * work[c][k];
+							result[r][k] -= factor * result[c][k];
+						}
+					}
+				}
+			}
+			// the translation column of the work matrix has been reduced to the translation of the inverse
+			for (std::size_t r = 0; r < Dim; ++r) {
+				result[r][Dim] = -work[r][Dim];
+			}
+			return result;
+		}
+	private:
+		/// \p constexpr absolute value.
+		[[nodiscard]] constexpr static T _abs(T v) {
+			return v < T{} ? -v : v;
+		}
+		/// \p constexpr swap.
+		constexpr static void _swap(T &a, T &b) {
+			T tmp = a;
+			a = b;
+			b = tmp;
+		}
+	};
+
+	/// A rigid transformation, i.e., a rotation followed by a translation. Rigid transformations preserve
+	/// \ref unit_vec objects.
+	template <typename T, std::size_t Dim> struct rigid {
+		friend affine<T, Dim>;
+	public:
+		/// No default constructor.
+		rigid() = delete;
+
+		/// Returns the identity transformation.
+		[[nodiscard]] constexpr static rigid identity() {
+			return rigid(affine<T, Dim>::identity());
+		}
+		/// Returns a translation.
+		[[nodiscard]] constexpr static rigid translation(const vec<T, Dim> &offset) {
+			return rigid(affine<T, Dim>::translation(offset));
+		}
+		/// Returns a counter-clockwise rotation around the origin.
+		template <
+			std::size_t D = Dim, typename = std::enable_if_t<D == 2>
+		> [[nodiscard]] static rigid rotation(T angle) {
+			T c = std::cos(angle), s = std::sin(angle);
+			affine<T, Dim> result;
+			result[0][0] = c;
+			result[0][1] = -s;
+			result[1][0] = s;
+			result[1][1] = c;
+			return rigid(result);
+		}
+		/// Returns a counter-clockwise rotation around the given axis.
+		template <
+			std::size_t D = Dim, typename = std::enable_if_t<D == 3>
+		> [[nodiscard]] static rigid rotation(const unit_vec<T, Dim> &axis, T angle) {
+			T c = std::cos(angle), s = std::sin(angle), t = static_cast<T>(1) - c;
+			T x = axis[0], y = axis[1], z = axis[2];
+			affine<T, Dim> result;
+			result[0][0] = t * x * x + c;
+			result[0][1] = t * x * y - s * z;
+			result[0][2] = t * x * z + s * y;
+			result[1][0] = t * x * y + s * z;
+			result[1][1] = t * y * y + c;
+			result[1][2] = t * y * z - s * x;
+			result[2][0] = t * x * z - s * y;
+			result[2][1] = t * y * z + s * x;
+			result[2][2] = t * z * z + c;
+			return rigid(result);
+		}
+		/// Treats the given affine transformation as a rigid transformation without checking that its linear part
+		/// is a rotation.
+		[[nodiscard]] constexpr static rigid from_affine_nocheck(const affine<T, Dim> &trans) {
+			return rigid(trans);
+		}
+
+		/// Returns the underlying affine transformation.
+		[[nodiscard]] constexpr const affine<T, Dim> &as_affine() const {
+			return _transform;
+		}
+		/// Returns the translation of this transformation.
+		[[nodiscard]] constexpr vec<T, Dim> get_translation() const {
+			return _transform.get_translation();
+		}
+
+		/// Transforms a point.
+		[[nodiscard]] constexpr point<T, Dim> transform(const point<T, Dim> &p) const {
+			return _transform.transform(p);
+		}
+		/// Transforms a vector.
+		[[nodiscard]] constexpr vec<T, Dim> transform(const vec<T, Dim> &v) const {
+			return _transform.transform(v);
+		}
+		/// Transforms a unit vector. The result is still a unit vector.
+		[[nodiscard]] constexpr unit_vec<T, Dim> transform(const unit_vec<T, Dim> &v) const {
+			return unit_vec<T, Dim>(_transform.transform(vec<T, Dim>(v)));
+		}
+		/// Composes two rigid transformations.
+		[[nodiscard]] constexpr rigid transform(const rigid &rhs) const {
+			return rigid(_transform.transform(rhs._transform));
+		}
+		/// Composes this transformation with an affine transformation.
+		[[nodiscard]] constexpr affine<T, Dim> transform(const affine<T, Dim> &rhs) const {
+			return _transform.transform(rhs);
+		}
+
+		/// Returns the inverse of this transformation. Since the linear part is orthonormal, its inverse is its
+		/// transpose.
+		[[nodiscard]] constexpr rigid inverse() const {
+			affine<T, Dim> result;
+			for (std::size_t r = 0; r < Dim; ++r) {
+				T offset{};
+				for (std::size_t c = 0; c < Dim; ++c) {
+					result[r][c] = _transform[c][r];
+					offset -= _transform[c][r] * _transform[c][Dim];
+				}
+				result[r][Dim] = offset;
+			}
+			return rigid(result);
+		}
+	private:
+		affine<T, Dim> _transform; ///< The underlying transformation.
+
+		/// Private conversion constructor from affine transformations.
+		constexpr explicit rigid(const affine<T, Dim> &trans) : _transform(trans) {
+		}
+	};
+
+	template <
+		typename T, std::size_t Dim
+	> constexpr affine<T, Dim>::affine(const rigid<T, Dim> &trans) : affine(trans._transform) {
+	}
+
+	namespace arithmetic_traits {
+		/// \ref affine * \ref point.
+		template <typename T, std::size_t Dim> struct transformation<affine<T, Dim>, point<T, Dim>> {
+			using result_type = point<T, Dim>; ///< Returns \ref point.
+		};
+		/// \ref affine * \ref vec.
+		template <typename T, std::size_t Dim> struct transformation<affine<T, Dim>, vec<T, Dim>> {
+			using result_type = vec<T, Dim>; ///< Returns \ref vec.
+		};
+		/// \ref affine * \ref unit_vec.
+		template <typename T, std::size_t Dim> struct transformation<affine<T, Dim>, unit_vec<T, Dim>> {
+			using result_type = vec<T, Dim>; ///< Returns \ref vec since the length may change.
+		};
+		/// \ref affine * \ref affine.
+		template <typename T, std::size_t Dim> struct transformation<affine<T, Dim>, affine<T, Dim>> {
+			using result_type = affine<T, Dim>; ///< Returns \ref affine.
+		};
+		/// \ref affine * \ref rigid.
+		template <typename T, std::size_t Dim> struct transformation<affine<T, Dim>, rigid<T, Dim>> {
+			using result_type = affine<T, Dim>; ///< Returns \ref affine.
+		};
+
+		/// \ref rigid * \ref point.
+		template <typename T, std::size_t Dim> struct transformation<rigid<T, Dim>, point<T, Dim>> {
+			using result_type = point<T, Dim>; ///< Returns \ref point.
+		};
+		/// \ref rigid * \ref vec.
+		template <typename T, std::size_t Dim> struct transformation<rigid<T, Dim>, vec<T, Dim>> {
+			using result_type = vec<T, Dim>; ///< Returns \ref vec.
+		};
+		/// \ref rigid * \ref unit_vec.
+		template <typename T, std::size_t Dim> struct transformation<rigid<T, Dim>, unit_vec<T, Dim>> {
+			using result_type = unit_vec<T, Dim>; ///< Returns \ref unit_vec.
+		};
+		/// \ref rigid * \ref rigid.
+		template <typename T, std::size_t Dim> struct transformation<rigid<T, Dim>, rigid<T, Dim>> {
+			using result_type = rigid<T, Dim>; ///< Returns \ref rigid.
+		};
+		/// \ref rigid * \ref affine.
+		template <typename T, std::size_t Dim> struct transformation<rigid<T, Dim>, affine<T, Dim>> {
+			using result_type = affine<T, Dim>; ///< Returns \ref affine.
+		};
+	}
+
+
+	namespace _details {
+		/// The number of elements processed at a time by the bulk transformation functions. AoS inputs are
+		/// transposed into blocks of this size so that the inner loops operate on contiguous lanes.
+		constexpr inline std::size_t transform_block_size = 64;
+
+		/// Transforms \p count elements stored as \p Dim separate lanes. Each output lane is a straight-line
+		/// multiply-add over the input lanes which compilers vectorize. Input and output may be the same.
+		template <bool Translate, typename T, std::size_t Dim> inline void transform_lanes(
+			const affine<T, Dim> &trans, const T *const *in, T *const *out, std::size_t count
+		) {
+			T results[Dim][transform_block_size];
+			for (std::size_t begin = 0; begin < count; begin += transform_block_size) {
+				std::size_t n = std::min(transform_block_size, count - begin);
+				for (std::size_t r = 0; r < Dim; ++r) {
+					T *res = results[r];
+					const T *in0 = in[0] + begin;
+					T m0 = trans[r][0], offset = Translate ? trans[r][Dim] : T{};
+					for (std::size_t i = 0; i < n; ++i) {
+						res[i] = m0 * in0[i] + offset;
+					}
+					for (std::size_t c = 1; c < Dim; ++c) {
+						const T *inc = in[c] + begin;
+						T mc = trans[r][c];
+						for (std::size_t i = 0; i < n; ++i) {
+							res[i] += mc * inc[i];
+						}
+					}
+				}
+				// write back only after all rows are computed so that in-place transformation works
+				for (std::size_t r = 0; r < Dim; ++r) {
+					std::copy(results[r], results[r] + n, out[r] + begin);
+				}
+			}
+		}
+
+		/// Transforms an AoS buffer by transposing blocks of it into lanes.
+		template <bool Translate, typename T, std::size_t Dim, typename Elem> inline void transform_aos(
+			const affine<T, Dim> &trans, const Elem *in, Elem *out, std::size_t count
+		) {
+			T lanes[Dim][transform_block_size];
+			const T *in_ptrs[Dim];
+			T *out_ptrs[Dim];
+			for (std::size_t i = 0; i < Dim; ++i) {
+				in_ptrs[i] = out_ptrs[i] = lanes[i];
+			}
+			for (std::size_t begin = 0; begin < count; begin += transform_block_size) {
+				std::size_t n = std::min(transform_block_size, count - begin);
+				for (std::size_t i = 0; i < n; ++i) {
+					for (std::size_t d = 0; d < Dim; ++d) {
+						lanes[d][i] = in[begin + i][d];
+					}
+				}
+				transform_lanes<Translate>(trans, in_ptrs, out_ptrs, n);
+				for (std::size_t i = 0; i < n; ++i) {
+					for (std::size_t d = 0; d < Dim; ++d) {
+						out[begin + i][d] = lanes[d][i];
+					}
+				}
+			}
+		}
+	}
+
+	/// Transforms \p count points. \p in and \p out may be the same buffer.
+	template <typename T, std::size_t Dim> inline void transform_points(
+		const affine<T, Dim> &trans, const point<T, Dim> *in, point<T, Dim> *out, std::size_t count
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(bulk_transform, count, point<T, Dim>);
+		_details::transform_aos<true>(trans, in, out, count);
+	}
+	/// Transforms points stored in a structure-of-arrays buffer. \p in and \p out must have the same size and may
+	/// refer to the same buffer.
+	template <typename T, std::size_t Dim> inline void transform_points(
+		const affine<T, Dim> &trans,
+		_details::identity_t<soa_span<const T, Dim>> in, _details::identity_t<soa_span<T, Dim>> out
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(bulk_transform, in.count, soa_span<T, Dim>);
+		_details::transform_lanes<true>(trans, &in.components[0], &out.components[0], in.count);
+	}
+	/// Transforms \p count vectors. Translation is ignored. \p in and \p out may be the same buffer.
+	template <typename T, std::size_t Dim> inline void transform_vecs(
+		const affine<T, Dim> &trans, const vec<T, Dim> *in, vec<T, Dim> *out, std::size_t count
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(bulk_transform, count, vec<T, Dim>);
+		_details::transform_aos<false>(trans, in, out, count);
+	}
+	/// Transforms vectors stored in a structure-of-arrays buffer. Translation is ignored. \p in and \p out must
+	/// have the same size and may refer to the same buffer.
+	template <typename T, std::size_t Dim> inline void transform_vecs(
+		const affine<T, Dim> &trans,
+		_details::identity_t<soa_span<const T, Dim>> in, _details::identity_t<soa_span<T, Dim>> out
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(bulk_transform, in.count, soa_span<T, Dim>);
+		_details::transform_lanes<false>(trans, &in.components[0], &out.components[0], in.count);
+	}
+
+
+	template <typename T> using affine2 = affine<T, 2>; ///< Shorthand for 2D affine transformations.
+	using affine2f = affine2<float>; ///< Shorthand for 2D \p float affine transformations.
+	using affine2d = affine2<double>; ///< Shorthand for 2D \p double affine transformations.
+
+	template <typename T> using affine3 = affine<T, 3>; ///< Shorthand for 3D affine transformations.
+	using affine3f = affine3<float>; ///< Shorthand for 3D \p float affine transformations.
+	using affine3d = affine3<double>; ///< Shorthand for 3D \p double affine transformations.
+
+	template <typename T> using rigid2 = rigid<T, 2>; ///< Shorthand for 2D rigid transformations.
+	using rigid2f = rigid2<float>; ///< Shorthand for 2D \p float rigid transformations.
+	using rigid2d = rigid2<double>; ///< Shorthand for 2D \p double rigid transformations.
+
+	template <typename T> using rigid3 = rigid<T, 3>; ///< Shorthand for 3D rigid transformations.
+	using rigid3f = rigid3<float>; ///< Shorthand for 3D \p float rigid transformations.
+	using rigid3d = rigid3<double>; ///< Shorthand for 3D \p double rigid transformations.
+}
@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include "common.h"
+#include "instrument.h"
 
 namespace math {
 	/// Dummy struct that marks the left hand side.
@@ -43,10 +44,24 @@ namespace math {
 			using scalar_side = void;
 		};
 
+		/// Application of a transformation to an object, or composition of two transformations. The result is
+		/// computed by \p Lhs::transform().
+		template <typename Lhs, typename Rhs> struct transformation {
+			using result_type = void; ///< Not supported by default.
+		};
+
 		/// Equality.
 		template <typename Lhs, typename Rhs> struct equality {
 			constexpr static bool enabled = false; ///< No equality operator.
 		};
+
+		/// Properties of scalar types, used by the traits of vector types. Custom scalar types can specialize this
+		/// struct.
+		template <typename T> struct scalar_type {
+			constexpr static bool enabled = std::is_arithmetic_v<T>; ///< Whether \p T can scale objects.
+			/// Whether arithmetic on \p T is reproducible so that equality comparisons are meaningful.
+			constexpr static bool exact = std::is_integral_v<T>;
+		};
 	}
 
 	namespace _details {
@@ -62,6 +77,7 @@ namespace math {
 		typename arithmetic_traits::memberwise_addition<Lhs, Rhs>::result_type
 	> operator+(const Lhs &lhs, const Rhs &rhs) {
 		typename arithmetic_traits::memberwise_addition<Lhs, Rhs>::result_type result;
+		CGMATH_INSTRUMENT_CALL(add, decltype(result));
 		arr::for_each(
 			[](auto &res, const auto &l, const auto &r) {
 				res = l + r;
@@ -74,6 +90,7 @@ namespace math {
 	template <typename Lhs, typename Rhs> constexpr std::enable_if_t<
 		std::is_same_v<typename arithmetic_traits::memberwise_addition<Lhs, Rhs>::result_type, Lhs>, Lhs&
 	> operator+=(Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(add_assign, Lhs);
 		arr::for_each(
 			[](auto &l, const auto &r) {
 				l += r;
@@ -88,6 +105,7 @@ namespace math {
 		typename arithmetic_traits::memberwise_subtraction<Lhs, Rhs>::result_type
 	> operator-(const Lhs &lhs, const Rhs &rhs) {
 		typename arithmetic_traits::memberwise_subtraction<Lhs, Rhs>::result_type result;
+		CGMATH_INSTRUMENT_CALL(subtract, decltype(result));
 		arr::for_each(
 			[](auto &res, const auto &l, const auto &r) {
 				res = l - r;
@@ -100,6 +118,7 @@ namespace math {
 	template <typename Lhs, typename Rhs> constexpr std::enable_if_t<
 		std::is_same_v<typename arithmetic_traits::memberwise_subtraction<Lhs, Rhs>::result_type, Lhs>, Lhs&
 	> operator-=(Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(subtract_assign, Lhs);
 		arr::for_each(
 			[](auto &l, const auto &r) {
 				l -= r;
@@ -114,6 +133,7 @@ namespace math {
 		typename arithmetic_traits::negation<Val>::result_type
 	> operator-(const Val &val) {
 		typename arithmetic_traits::negation<Val>::result_type result;
+		CGMATH_INSTRUMENT_CALL(negate, decltype(result));
 		arr::for_each(
 			[](auto &l, const auto &r) {
 				l -= r;
@@ -128,6 +148,7 @@ namespace math {
 		typename arithmetic_traits::scalar_multiplication<Lhs, Rhs>::result_type
 	> operator*(const Lhs &lhs, const Rhs &rhs) {
 		typename arithmetic_traits::scalar_multiplication<Lhs, Rhs>::result_type result;
+		CGMATH_INSTRUMENT_CALL(multiply, decltype(result));
 		if constexpr (
 			std::is_same_v<typename arithmetic_traits::scalar_multiplication<Lhs, Rhs>::scalar_side, left_hand_side>
 		) { // scalar on left hand side
@@ -153,6 +174,7 @@ namespace math {
 		std::is_same_v<typename arithmetic_traits::scalar_multiplication<Lhs, Rhs>::scalar_side, right_hand_side>,
 		Lhs&
 	> operator*=(Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(multiply_assign, Lhs);
 		arr::for_each(
 			[&rhs](auto &l) {
 				l *= rhs;
@@ -167,6 +189,7 @@ namespace math {
 		typename arithmetic_traits::scalar_division<Lhs, Rhs>::result_type
 	> operator/(const Lhs &lhs, const Rhs &rhs) {
 		typename arithmetic_traits::scalar_division<Lhs, Rhs>::result_type result;
+		CGMATH_INSTRUMENT_CALL(divide, decltype(result));
 		if constexpr (
 			std::is_same_v<typename arithmetic_traits::scalar_division<Lhs, Rhs>::scalar_side, left_hand_side>
 		) { // scalar on left hand side
@@ -192,6 +215,7 @@ namespace math {
 		std::is_same_v<typename arithmetic_traits::scalar_division<Lhs, Rhs>::scalar_side, right_hand_side>,
 		Lhs&
 	> operator/=(Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(divide_assign, Lhs);
 		arr::for_each(
 			[&rhs](auto &l) {
 				l /= rhs;
@@ -201,11 +225,20 @@ namespace math {
 		return lhs;
 	}
 
+	/// Transformation.
+	template <typename Lhs, typename Rhs> [[nodiscard]] constexpr _details::enable_if_nonvoid_t<
+		typename arithmetic_traits::transformation<Lhs, Rhs>::result_type
+	> operator*(const Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(transform, Lhs);
+		return lhs.transform(rhs);
+	}
+
 
 	/// Equality.
 	template <typename Lhs, typename Rhs> [[nodiscard]] constexpr std::enable_if_t<
 		arithmetic_traits::equality<Lhs, Rhs>::enabled, bool
 	> operator==(const Lhs &lhs, const Rhs &rhs) {
+		CGMATH_INSTRUMENT_CALL(equal, Lhs);
 		bool result = true;
 		arr::for_each(
 			[&result](const auto &l, const auto &r) {
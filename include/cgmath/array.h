@@ -7,22 +7,25 @@
 #include <utility>
 
 namespace math {
-	/// N-dimensional arrays.
-	template <typename T, std::size_t FirstSize, std::size_t ...Sizes> struct array {
-	private:
-		/// Used to correctly obtain \ref value_type without creating invalid specializations.
-		template <bool UseSubarrays> struct _value_type {
+	template <typename T, std::size_t FirstSize, std::size_t ...Sizes> struct array;
+	namespace _details {
+		/// Used to correctly obtain \ref array::value_type without creating invalid specializations.
+		template <typename T, std::size_t ...Sizes> struct array_value_type {
 			using type = array<T, Sizes...>; ///< Element type.
 		};
 		/// Specialization for 1D arrays.
-		template <> struct _value_type<false> {
+		template <typename T> struct array_value_type<T> {
 			using type = T; ///< Element type.
 		};
+	}
+
+	/// N-dimensional arrays.
+	template <typename T, std::size_t FirstSize, std::size_t ...Sizes> struct array {
 	public:
 		using element_type = T; ///< The type of elements stored in this array.
 		using dimensions = std::index_sequence<FirstSize, Sizes...>; ///< The dimensions of this array.
 		/// The type of elements of this `layer' of the array.
-		using value_type = typename _value_type<sizeof...(Sizes) != 0>::type;
+		using value_type = typename _details::array_value_type<T, Sizes...>::type;
 
 		/// Returns the size of this array. For multidimensional arrays, this is the size of the first dimension.
 		[[nodiscard]] constexpr static std::size_t size() {
@@ -8,6 +8,27 @@
 #include <type_traits>
 
 namespace math {
+	namespace _details {
+		// TODO std::type_identity in C++20.
+		/// Identity type, used to exclude function parameters from template argument deduction.
+		template <typename T> struct identity {
+			using type = T; ///< The type itself.
+		};
+		/// Shorthand for \ref identity::type.
+		template <typename T> using identity_t = typename identity<T>::type;
+
+		// TODO std::is_constant_evaluated in C++20.
+		/// Returns whether the call is evaluated in a constant expression. Compilers without the builtin always
+		/// take the \p constexpr path, which is correct but slower at runtime.
+		[[nodiscard]] constexpr bool is_constant_evaluated() {
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+			return __builtin_is_constant_evaluated();
+#else
+			return true;
+#endif
+		}
+	}
+
 	/// Wrapper around a boolean that indicates whether to break a loop.
 	struct break_loop {
 		/// Explicit constructor.
@@ -20,31 +41,24 @@ namespace math {
 	/// Operations for statically-sized array-like objects.
 	namespace arr {
 		namespace _details {
-			/// End of recursion.
-			template <typename Callback, typename ...Args> constexpr void _for_each_impl(Callback&&, Args&&...) {
+			/// Calls the callback function using the \p I-th element of each input array.
+			template <std::size_t I, typename Callback, typename ...Args> constexpr decltype(auto) _call(
+				Callback &cb, Args &...args
+			) {
+				return cb(args[I]...);
 			}
-			/// Implementation of \ref for_each().
+			/// Implementation of \ref for_each(). All elements are visited by a single fold expression instead of
+			/// one recursive instantiation per element, so debug builds also get a flat sequence of calls. Folding
+			/// over \p || stops at the first callback that requests a break.
 			template <
-				std::size_t FirstId, std::size_t ...OtherIds, typename Callback, typename ...Args
-			> constexpr void _for_each_impl(Callback &&cb, Args &&...args) {
-				using return_type = std::invoke_result_t<Callback&&, decltype(args[FirstId])...>;
+				typename Callback, typename ...Args, std::size_t ...Indices
+			> constexpr void _for_each_impl(std::index_sequence<Indices...>, Callback &cb, Args &...args) {
+				using return_type = std::invoke_result_t<Callback&, decltype(args[0])...>;
 				if constexpr (std::is_same_v<return_type, break_loop>) {
-					if (std::forward<Callback>(cb)(args[FirstId]...).do_break) {
-						return;
-					}
+					static_cast<void>((_call<Indices>(cb, args...).do_break || ...));
 				} else {
-					std::forward<Callback>(cb)(args[FirstId]...);
+					(static_cast<void>(_call<Indices>(cb, args...)), ...);
 				}
-				_for_each_impl<OtherIds...>(std::forward<Callback>(cb), std::forward<Args>(args)...);
-			}
-
-			/// Wrapper around \ref _for_each_impl().
-			template <
-				typename Callback, typename ...Args, std::size_t ...Indices
-			> constexpr void _for_each_impl_wrapper(
-				std::index_sequence<Indices...>, Callback &&cb, Args &&...args
-			) {
-				_for_each_impl<Indices...>(std::forward<Callback>(cb), std::forward<Args>(args)...);
 			}
 		}
 		/// Calls the callback function using each element in each input array.
@@ -55,10 +69,7 @@ namespace math {
 				((std::decay_t<FirstArg>::size() == others.size()) && ...),
 				"All arrays must have the same size."
 			);
-			_details::_for_each_impl_wrapper(
-				std::make_index_sequence<first.size()>{},
-				std::forward<Callback>(cb), std::forward<FirstArg>(first), std::forward<OtherArgs>(others)...
-			);
+			_details::_for_each_impl(std::make_index_sequence<std::decay_t<FirstArg>::size()>{}, cb, first, others...);
 		}
 	}
 }
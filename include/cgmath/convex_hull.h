@@ -0,0 +1,561 @@
+#pragma once
+
+/// \file
+/// Convex hulls of 2D and 3D point sets.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "array.h"
+#include "vec.h"
+#include "point.h"
+#include "parallel.h"
+#include "predicates.h"
+
+namespace math {
+	namespace _details {
+		/// Inputs with at least this many points per thread are split into chunks whose hulls are computed
+		/// concurrently and then merged.
+		constexpr inline std::size_t hull_min_chunk_size = 1 << 15;
+
+		/// Returns whether \p a is lexicographically smaller than \p b.
+		template <typename T, std::size_t Dim> [[nodiscard]] inline bool lexicographic_less(
+			const point<T, Dim> &a, const point<T, Dim> &b
+		) {
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if (a[d] != b[d]) {
+					return a[d] < b[d];
+				}
+			}
+			return false;
+		}
+		/// Returns the cross product of two 3D vectors.
+		template <typename T> [[nodiscard]] inline vec<T, 3> cross(const vec<T, 3> &a, const vec<T, 3> &b) {
+			return vec<T, 3>(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]);
+		}
+		/// Returns whether two points are identical.
+		template <typename T, std::size_t Dim> [[nodiscard]] inline bool same_point(
+			const point<T, Dim> &a, const point<T, Dim> &b
+		) {
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if (a[d] != b[d]) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/// Sorts the given points and computes their convex hull using Andrew's monotone chain algorithm. The
+		/// result is in counter-clockwise order starting from the lexicographically smallest point, and contains
+		/// no collinear points.
+		template <typename T> inline void monotone_chain(
+			const point<T, 2> *points, std::vector<std::size_t> &indices, std::vector<std::size_t> &hull
+		) {
+			std::sort(
+				indices.begin(), indices.end(),
+				[points](std::size_t a, std::size_t b) {
+					return lexicographic_less(points[a], points[b]) ||
+						(same_point(points[a], points[b]) && a < b);
+				}
+			);
+			indices.erase(
+				std::unique(
+					indices.begin(), indices.end(),
+					[points](std::size_t a, std::size_t b) {
+						return same_point(points[a], points[b]);
+					}
+				),
+				indices.end()
+			);
+			hull.clear();
+			if (indices.size() < 3) {
+				hull = indices;
+				return;
+			}
+			hull.resize(2 * indices.size());
+			std::size_t size = 0;
+			auto push = [&](std::size_t i, std::size_t min_size) {
+				while (
+					size >= min_size &&
+					predicates::orient2d(points[hull[size - 2]], points[hull[size - 1]], points[i]) <= T{}
+				) {
+					--size;
+				}
+				hull[size++] = i;
+			};
+			for (std::size_t i : indices) { // lower hull
+				push(i, 2);
+			}
+			std::size_t lower = size + 1;
+			for (std::size_t i = indices.size() - 1; i-- > 0; ) { // upper hull
+				push(indices[i], lower);
+			}
+			hull.resize(size - 1); // the first point is repeated at the end
+		}
+
+		/// Computes the hull of a range of points, after discarding points that are strictly inside the
+		/// quadrilateral formed by the extreme points along both axes (the Akl-Toussaint heuristic).
+		template <typename T> inline void convex_hull_range(
+			const point<T, 2> *points, std::size_t begin, std::size_t end, std::vector<std::size_t> &hull
+		) {
+			std::vector<std::size_t> candidates;
+			hull.clear();
+			if (begin == end) {
+				return;
+			}
+			// extreme points, with ties broken so that they are all vertices of the hull in counter-clockwise order
+			std::size_t extremes[4] = { begin, begin, begin, begin };
+			for (std::size_t i = begin + 1; i < end; ++i) {
+				const point<T, 2> &p = points[i];
+				auto better = [&](std::size_t cur, std::size_t x, bool x_max, std::size_t y, bool y_max) {
+					T px = p[x], cx = points[cur][x];
+					if (px != cx) {
+						return x_max ? px > cx : px < cx;
+					}
+					return y_max ? p[y] > points[cur][y] : p[y] < points[cur][y];
+				};
+				extremes[0] = better(extremes[0], 0, false, 1, false) ? i : extremes[0]; // left
+				extremes[1] = better(extremes[1], 1, false, 0, true) ? i : extremes[1]; // bottom
+				extremes[2] = better(extremes[2], 0, true, 1, true) ? i : extremes[2]; // right
+				extremes[3] = better(extremes[3], 1, true, 0, false) ? i : extremes[3]; // top
+			}
+			candidates.reserve(end - begin);
+			for (std::size_t i = begin; i < end; ++i) {
+				bool inside = true;
+				for (std::size_t e = 0; e < 4 && inside; ++e) {
+					const point<T, 2> &a = points[extremes[e]], &b = points[extremes[(e + 1) % 4]];
+					inside = predicates::orient2d(a, b, points[i]) > T{};
+				}
+				if (!inside) {
+					candidates.emplace_back(i);
+				}
+			}
+			monotone_chain(points, candidates, hull);
+		}
+
+		/// Working state of the QuickHull algorithm in 3D.
+		template <typename T> struct quickhull3 {
+		public:
+			/// A triangle of the hull.
+			struct face {
+				std::size_t
+					vertices[3], ///< Vertices in counter-clockwise order when viewed from outside.
+					neighbors[3]; ///< The face across the edge from vertex i to vertex i + 1.
+				vec<T, 3> normal; ///< Unnormalized outward normal, used to pick the farthest point.
+				std::vector<std::size_t> outside; ///< Points that are strictly above this face.
+				std::size_t farthest = 0; ///< The outside point with the largest approximate distance.
+				T farthest_distance{}; ///< The approximate distance of \ref farthest.
+				std::size_t visit_stamp = 0; ///< The last iteration in which this face has been visited.
+				bool visible = false; ///< Whether this face is visible from the current eye point.
+				bool alive = false; ///< Whether this face is part of the hull.
+			};
+
+			/// Initializes the state for computing hulls of points with indices in [\p first, \p last).
+			quickhull3(const point<T, 3> *pts, std::size_t first, std::size_t last) :
+				_points(pts), _start_of(last - first, no_face), _end_of(last - first, no_face),
+				_first_index(first) {
+			}
+
+			/// Computes the hull of the given points. Returns nothing if all points are coplanar.
+			void compute(const std::vector<std::size_t> &indices, std::vector<array<std::size_t, 3>> &result) {
+				result.clear();
+				std::size_t simplex[4];
+				if (!_initial_simplex(indices, simplex)) {
+					return;
+				}
+				for (std::size_t i : indices) {
+					_assign(i, 0, 4);
+				}
+				std::vector<std::size_t> pending;
+				for (std::size_t f = 0; f < 4; ++f) {
+					pending.emplace_back(f);
+				}
+				while (!pending.empty()) {
+					std::size_t f = pending.back();
+					pending.pop_back();
+					if (!_faces[f].alive || _faces[f].outside.empty()) {
+						continue;
+					}
+					std::size_t first_new = _faces.size();
+					_add_point(f);
+					for (std::size_t n = first_new; n < _faces.size(); ++n) {
+						if (!_faces[n].outside.empty()) {
+							pending.emplace_back(n);
+						}
+					}
+				}
+				for (const face &f : _faces) {
+					if (f.alive) {
+						result.emplace_back();
+						for (std::size_t v = 0; v < 3; ++v) {
+							result.back()[v] = f.vertices[v];
+						}
+					}
+				}
+			}
+		private:
+			constexpr static std::size_t no_face = std::numeric_limits<std::size_t>::max(); ///< Invalid face.
+
+			const point<T, 3> *_points = nullptr; ///< Input points.
+			std::vector<face> _faces; ///< All faces, including the ones that have been removed.
+			std::vector<std::size_t>
+				_start_of, ///< For each horizon vertex, the new face whose horizon edge starts at it.
+				_end_of, ///< For each horizon vertex, the new face whose horizon edge ends at it.
+				_visible, ///< Faces visible from the current eye point.
+				_horizon_faces, ///< Visible faces on the horizon.
+				_horizon_edges, ///< Horizon edges of \ref _horizon_faces.
+				_orphans; ///< Outside points of removed faces.
+			std::size_t
+				_first_index = 0, ///< The smallest point index, used to index into \ref _start_of and \ref _end_of.
+				_iteration = 0; ///< The number of points that have been added.
+
+			/// Returns whether the point is strictly above the face.
+			[[nodiscard]] bool _above(const face &f, std::size_t p) const {
+				return predicates::orient3d(
+					_points[f.vertices[0]], _points[f.vertices[1]], _points[f.vertices[2]], _points[p]
+				) > T{};
+			}
+
+			/// Adds a face and returns its index. Removed faces are not reused, since their indices may still be
+			/// pending.
+			std::size_t _add_face(std::size_t a, std::size_t b, std::size_t c) {
+				face &f = _faces.emplace_back();
+				f.vertices[0] = a;
+				f.vertices[1] = b;
+				f.vertices[2] = c;
+				f.neighbors[0] = f.neighbors[1] = f.neighbors[2] = no_face;
+				f.normal = cross(_points[b] - _points[a], _points[c] - _points[a]);
+				f.alive = true;
+				return _faces.size() - 1;
+			}
+
+			/// Assigns a point to the first face in [\p begin, \p end) that it is strictly above, if any.
+			void _assign(std::size_t p, std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i) {
+					face &f = _faces[i];
+					if (_above(f, p)) {
+						T dist = vec<T, 3>::dot(f.normal, _points[p] - _points[f.vertices[0]]);
+						if (f.outside.empty() || dist > f.farthest_distance) {
+							f.farthest = p;
+							f.farthest_distance = dist;
+						}
+						f.outside.emplace_back(p);
+						return;
+					}
+				}
+			}
+
+			/// Finds four points that are not coplanar and creates the initial tetrahedron.
+			bool _initial_simplex(const std::vector<std::size_t> &indices, std::size_t (&simplex)[4]) {
+				if (indices.size() < 4) {
+					return false;
+				}
+				auto less = [this](std::size_t a, std::size_t b) {
+					return lexicographic_less(_points[a], _points[b]);
+				};
+				simplex[0] = *std::min_element(indices.begin(), indices.end(), less);
+				simplex[1] = *std::max_element(indices.begin(), indices.end(), less);
+				const point<T, 3> &p0 = _points[simplex[0]], &p1 = _points[simplex[1]];
+				if (same_point(p0, p1)) {
+					return false;
+				}
+
+				// the point farthest from the line, falling back to any point that is not exactly collinear
+				vec<T, 3> dir = p1 - p0;
+				auto collinear = [&](std::size_t i) {
+					const point<T, 3> &p = _points[i];
+					for (std::size_t d = 0; d < 3; ++d) {
+						std::size_t d1 = (d + 1) % 3;
+						point<T, 2> a(p0[d], p0[d1]), b(p1[d], p1[d1]), c(p[d], p[d1]);
+						if (predicates::orient2d(a, b, c) != T{}) {
+							return false;
+						}
+					}
+					return true;
+				};
+				T best = -static_cast<T>(1);
+				for (std::size_t i : indices) {
+					T dist = cross(dir, _points[i] - p0).squared_norm();
+					if (dist > best) {
+						best = dist;
+						simplex[2] = i;
+					}
+				}
+				if (collinear(simplex[2])) {
+					auto it = std::find_if_not(indices.begin(), indices.end(), collinear);
+					if (it == indices.end()) {
+						return false;
+					}
+					simplex[2] = *it;
+				}
+
+				// the point farthest from the plane, falling back to any point that is not exactly coplanar
+				const point<T, 3> &p2 = _points[simplex[2]];
+				vec<T, 3> normal = cross(dir, p2 - p0);
+				best = -static_cast<T>(1);
+				for (std::size_t i : indices) {
+					T dist = std::abs(vec<T, 3>::dot(normal, _points[i] - p0));
+					if (dist > best) {
+						best = dist;
+						simplex[3] = i;
+					}
+				}
+				auto coplanar = [&](std::size_t i) {
+					return predicates::orient3d(p0, p1, p2, _points[i]) == T{};
+				};
+				if (coplanar(simplex[3])) {
+					auto it = std::find_if_not(indices.begin(), indices.end(), coplanar);
+					if (it == indices.end()) {
+						return false;
+					}
+					simplex[3] = *it;
+				}
+
+				// create the faces so that the remaining vertex is below each face
+				constexpr std::size_t faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 }, { 2, 3, 0, 1 } };
+				for (const auto &f : faces) {
+					std::size_t a = simplex[f[0]], b = simplex[f[1]], c = simplex[f[2]];
+					if (predicates::orient3d(_points[a], _points[b], _points[c], _points[simplex[f[3]]]) > T{}) {
+						std::swap(b, c);
+					}
+					_add_face(a, b, c);
+				}
+				for (std::size_t f = 0; f < 4; ++f) {
+					for (std::size_t e = 0; e < 3; ++e) {
+						std::size_t a = _faces[f].vertices[e], b = _faces[f].vertices[(e + 1) % 3];
+						for (std::size_t g = 0; g < 4; ++g) {
+							for (std::size_t ge = 0; ge < 3; ++ge) {
+								if (_faces[g].vertices[ge] == b && _faces[g].vertices[(ge + 1) % 3] == a) {
+									_faces[f].neighbors[e] = g;
+								}
+							}
+						}
+					}
+				}
+				return true;
+			}
+
+			/// Adds the farthest outside point of the given face to the hull.
+			void _add_point(std::size_t seed) {
+				std::size_t eye = _faces[seed].farthest;
+				++_iteration;
+
+				// find visible faces and the horizon using a depth-first search
+				_visible.clear();
+				_horizon_faces.clear();
+				_horizon_edges.clear();
+				_faces[seed].visit_stamp = _iteration;
+				_faces[seed].visible = true;
+				_visible.emplace_back(seed);
+				for (std::size_t i = 0; i < _visible.size(); ++i) {
+					std::size_t f = _visible[i];
+					for (std::size_t e = 0; e < 3; ++e) {
+						std::size_t n = _faces[f].neighbors[e];
+						if (_faces[n].visit_stamp != _iteration) {
+							_faces[n].visit_stamp = _iteration;
+							_faces[n].visible = _above(_faces[n], eye);
+							if (_faces[n].visible) {
+								_visible.emplace_back(n);
+							}
+						}
+						if (!_faces[n].visible) {
+							_horizon_faces.emplace_back(f);
+							_horizon_edges.emplace_back(e);
+						}
+					}
+				}
+
+				// create a cone of faces from the horizon to the eye point
+				std::size_t first_new = _faces.size();
+				for (std::size_t h = 0; h < _horizon_faces.size(); ++h) {
+					std::size_t f = _horizon_faces[h], e = _horizon_edges[h];
+					std::size_t a = _faces[f].vertices[e], b = _faces[f].vertices[(e + 1) % 3];
+					std::size_t across = _faces[f].neighbors[e];
+					std::size_t created = _add_face(a, b, eye);
+					_faces[created].neighbors[0] = across;
+					for (std::size_t &n : _faces[across].neighbors) {
+						if (n == f) {
+							n = created;
+						}
+					}
+					_start_of[a - _first_index] = created;
+					_end_of[b - _first_index] = created;
+				}
+				for (std::size_t f = first_new; f < _faces.size(); ++f) {
+					face &cur = _faces[f];
+					cur.neighbors[1] = _start_of[cur.vertices[1] - _first_index];
+					cur.neighbors[2] = _end_of[cur.vertices[0] - _first_index];
+				}
+
+				// remove visible faces and reassign their outside points
+				_orphans.clear();
+				for (std::size_t f : _visible) {
+					face &cur = _faces[f];
+					cur.alive = false;
+					cur.visible = false;
+					for (std::size_t p : cur.outside) {
+						if (p != eye) {
+							_orphans.emplace_back(p);
+						}
+					}
+					cur.outside = std::vector<std::size_t>();
+				}
+				for (std::size_t p : _orphans) {
+					_assign(p, first_new, _faces.size());
+				}
+			}
+		};
+
+		/// Discards points that are strictly inside the hull of the extreme points along the axes and the
+		/// diagonals (the Akl-Toussaint heuristic), which are also strictly inside the hull of all points.
+		template <typename T> inline void akl_toussaint_filter(
+			const point<T, 3> *points, std::size_t first, std::size_t last, const std::vector<std::size_t> &indices,
+			std::vector<std::size_t> &candidates
+		) {
+			constexpr std::size_t num_directions = 13; // opposite directions are handled together
+			constexpr int directions[num_directions][3]{
+				{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+				{ 1, 1, 0 }, { 1, -1, 0 }, { 1, 0, 1 }, { 1, 0, -1 }, { 0, 1, 1 }, { 0, 1, -1 },
+				{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 }
+			};
+			candidates = indices;
+			if (indices.empty()) {
+				return;
+			}
+			std::size_t extremes[2 * num_directions];
+			T values[2 * num_directions];
+			for (std::size_t i : indices) {
+				const point<T, 3> &p = points[i];
+				for (std::size_t d = 0; d < num_directions; ++d) {
+					T value = p[0] * static_cast<T>(directions[d][0]) + p[1] * static_cast<T>(directions[d][1]) +
+						p[2] * static_cast<T>(directions[d][2]);
+					if (i == indices.front() || value < values[2 * d]) {
+						values[2 * d] = value;
+						extremes[2 * d] = i;
+					}
+					if (i == indices.front() || value > values[2 * d + 1]) {
+						values[2 * d + 1] = value;
+						extremes[2 * d + 1] = i;
+					}
+				}
+			}
+			std::vector<std::size_t> vertices(extremes, extremes + 2 * num_directions);
+			std::sort(vertices.begin(), vertices.end());
+			vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+			std::vector<array<std::size_t, 3>> faces;
+			quickhull3<T>(points, first, last).compute(vertices, faces);
+			if (faces.empty()) { // the extreme points are coplanar
+				return;
+			}
+			candidates.clear();
+			for (std::size_t i : indices) {
+				const point<T, 3> &p = points[i];
+				bool inside = true;
+				for (std::size_t f = 0; f < faces.size() && inside; ++f) {
+					const array<std::size_t, 3> &tri = faces[f];
+					inside = predicates::orient3d(points[tri[0]], points[tri[1]], points[tri[2]], p) < T{};
+				}
+				if (!inside) {
+					candidates.emplace_back(i);
+				}
+			}
+		}
+
+		/// Computes the hull of the given points with indices in [\p first, \p last) using QuickHull, after
+		/// discarding points with \ref akl_toussaint_filter().
+		template <typename T> inline void convex_hull_range(
+			const point<T, 3> *points, std::size_t first, std::size_t last, const std::vector<std::size_t> &indices,
+			std::vector<array<std::size_t, 3>> &hull
+		) {
+			std::vector<std::size_t> candidates;
+			akl_toussaint_filter(points, first, last, indices, candidates);
+			quickhull3<T> state(points, first, last);
+			state.compute(candidates, hull);
+		}
+	}
+
+	/// Computes the convex hull of \p count 2D points. Large inputs are split into chunks whose hulls are
+	/// computed concurrently, and the final hull is computed from the vertices of those hulls. All orientation
+	/// tests are exact.
+	///
+	/// \return Indices of the hull vertices in counter-clockwise order, starting from the lexicographically
+	///         smallest point. Collinear points on hull edges and duplicate points are omitted. If all points are
+	///         collinear, the two endpoints are returned.
+	template <typename T> [[nodiscard]] inline std::vector<std::size_t> convex_hull(
+		const point<T, 2> *points, std::size_t count,
+		std::size_t num_threads = parallel::default_thread_count()
+	) {
+		std::size_t chunks = parallel::chunk_count(count, num_threads, _details::hull_min_chunk_size);
+		std::vector<std::vector<std::size_t>> chunk_hulls(chunks);
+		parallel::for_each_chunk(
+			count, num_threads, _details::hull_min_chunk_size,
+			[&](std::size_t chunk, std::size_t begin, std::size_t end) {
+				_details::convex_hull_range(points, begin, end, chunk_hulls[chunk]);
+			}
+		);
+		if (chunks == 1) {
+			return std::move(chunk_hulls[0]);
+		}
+		std::vector<std::size_t> candidates, hull;
+		for (const std::vector<std::size_t> &chunk_hull : chunk_hulls) {
+			candidates.insert(candidates.end(), chunk_hull.begin(), chunk_hull.end());
+		}
+		_details::monotone_chain(points, candidates, hull);
+		return hull;
+	}
+
+	/// Computes the convex hull of \p count 3D points using QuickHull, after discarding points that are strictly
+	/// inside the hull of the extreme points along the axes and diagonals. Large inputs are split into chunks
+	/// whose hulls are computed concurrently, and the final hull is computed from the vertices of those hulls.
+	/// All orientation tests are exact.
+	///
+	/// \return Triangles of the hull as indices of their vertices, in counter-clockwise order when viewed from
+	///         outside. Coplanar faces are triangulated arbitrarily. If all points are coplanar, the result is
+	///         empty.
+	template <typename T> [[nodiscard]] inline std::vector<array<std::size_t, 3>> convex_hull(
+		const point<T, 3> *points, std::size_t count,
+		std::size_t num_threads = parallel::default_thread_count()
+	) {
+		std::size_t chunks = parallel::chunk_count(count, num_threads, _details::hull_min_chunk_size);
+		std::vector<array<std::size_t, 3>> hull;
+		if (chunks == 1) {
+			std::vector<std::size_t> indices(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				indices[i] = i;
+			}
+			_details::convex_hull_range(points, 0, count, indices, hull);
+			return hull;
+		}
+		// vertices of the hull of each chunk, or all points of the chunk if they are coplanar
+		std::vector<std::vector<std::size_t>> chunk_vertices(chunks);
+		parallel::for_each_chunk(
+			count, num_threads, _details::hull_min_chunk_size,
+			[&](std::size_t chunk, std::size_t begin, std::size_t end) {
+				std::vector<std::size_t> &vertices = chunk_vertices[chunk];
+				vertices.resize(end - begin);
+				for (std::size_t i = begin; i < end; ++i) {
+					vertices[i - begin] = i;
+				}
+				std::vector<array<std::size_t, 3>> chunk_hull;
+				_details::convex_hull_range(points, begin, end, vertices, chunk_hull);
+				if (!chunk_hull.empty()) {
+					vertices.clear();
+					for (const array<std::size_t, 3> &tri : chunk_hull) {
+						vertices.insert(vertices.end(), &tri[0], &tri[0] + 3);
+					}
+					std::sort(vertices.begin(), vertices.end());
+					vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+				}
+			}
+		);
+		std::vector<std::size_t> candidates;
+		for (const std::vector<std::size_t> &vertices : chunk_vertices) {
+			candidates.insert(candidates.end(), vertices.begin(), vertices.end());
+		}
+		_details::convex_hull_range(points, 0, count, candidates, hull);
+		return hull;
+	}
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+/// \file
+/// View frustums and culling of axis-aligned bounding boxes against sets of planes.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "vec.h"
+#include "point.h"
+#include "plane.h"
+#include "affine.h"
+#include "soa.h"
+#include "parallel.h"
+#include "instrument.h"
+
+namespace math {
+	/// The result of classifying an object against a convex region.
+	enum class containment : unsigned char {
+		outside, ///< The object is completely outside of the region.
+		intersecting, ///< The object may intersect the boundary of the region.
+		inside ///< The object is completely inside the region.
+	};
+
+	/// A view frustum, represented as six planes facing inwards.
+	template <typename T> struct frustum {
+		/// Indices of the planes.
+		enum plane_index : std::size_t {
+			near_plane, ///< The near plane.
+			far_plane, ///< The far plane.
+			left_plane, ///< The left plane.
+			right_plane, ///< The right plane.
+			bottom_plane, ///< The bottom plane.
+			top_plane, ///< The top plane.
+
+			num_planes ///< The number of planes.
+		};
+
+		/// Creates a perspective frustum. In camera space the camera looks towards -Z with +Y up and +X right.
+		///
+		/// \param camera_to_world The transformation from camera space to world space.
+		/// \param vertical_fov The vertical field of view in radians.
+		/// \param aspect_ratio Width divided by height.
+		[[nodiscard]] static frustum perspective(
+			const rigid<T, 3> &camera_to_world, T vertical_fov, T aspect_ratio, T near_dist, T far_dist
+		) {
+			T tan_y = std::tan(vertical_fov / static_cast<T>(2)), tan_x = tan_y * aspect_ratio;
+			point<T, 3> eye = camera_to_world * point<T, 3>(T{}, T{}, T{});
+			auto side = [&](T x, T y, T z) {
+				unit_vec<T, 3> normal = camera_to_world * vec<T, 3>(x, y, z).normalized_nocheck().result;
+				return plane<T, 3>::from_point_normal(eye, normal);
+			};
+			auto cap = [&](T z, T dist) {
+				unit_vec<T, 3> normal = camera_to_world * vec<T, 3>(T{}, T{}, z).normalized_nocheck().result;
+				return plane<T, 3>::from_point_normal(
+					camera_to_world * point<T, 3>(T{}, T{}, -dist), normal
+				);
+			};
+			constexpr T one = static_cast<T>(1);
+			return frustum{ {
+				cap(-one, near_dist), cap(one, far_dist),
+				side(one, T{}, -tan_x), side(-one, T{}, -tan_x),
+				side(T{}, one, -tan_y), side(T{}, -one, -tan_y)
+			} };
+		}
+
+		std::array<plane<T, 3>, num_planes> planes; ///< The planes.
+	};
+
+
+	/// A structure-of-arrays view of axis-aligned bounding boxes.
+	template <typename T, std::size_t Dim> struct aabb_span {
+		/// Returns the number of boxes.
+		[[nodiscard]] constexpr std::size_t count() const {
+			return min.count;
+		}
+
+		soa_span<const T, Dim>
+			min, ///< Minimum coordinates of all boxes.
+			max; ///< Maximum coordinates of all boxes.
+	};
+
+	namespace _details {
+		/// The number of boxes processed at a time by the culling kernels.
+		constexpr inline std::size_t cull_block_size = 16;
+
+		/// A plane prepared for culling.
+		template <typename T, std::size_t Dim> struct cull_plane {
+			T normal[Dim]; ///< The normal of the plane.
+			T offset; ///< The offset of the plane.
+			/// For each dimension, the lane that contains coordinates of the corner farthest along the normal.
+			const T *positive_lanes[Dim];
+			/// For each dimension, the lane that contains coordinates of the corner farthest against the normal.
+			const T *negative_lanes[Dim];
+		};
+
+		/// Prepares planes for culling. Selecting the extreme corners per plane, rather than per box, keeps the
+		/// kernel free of branches.
+		template <typename T, std::size_t Dim> inline std::vector<cull_plane<T, Dim>> prepare_cull_planes(
+			const plane<T, Dim> *planes, std::size_t num_planes, const aabb_span<T, Dim> &boxes
+		) {
+			std::vector<cull_plane<T, Dim>> result(num_planes);
+			for (std::size_t i = 0; i < num_planes; ++i) {
+				cull_plane<T, Dim> &pl = result[i];
+				pl.offset = planes[i].offset;
+				for (std::size_t d = 0; d < Dim; ++d) {
+					pl.normal[d] = planes[i].normal[d];
+					bool positive = pl.normal[d] >= T{};
+					pl.positive_lanes[d] = positive ? boxes.max.components[d] : boxes.min.components[d];
+					pl.negative_lanes[d] = positive ? boxes.min.components[d] : boxes.max.components[d];
+				}
+			}
+			return result;
+		}
+
+		/// Classifies up to \ref cull_block_size boxes starting from \p begin. For each box, \p outside and
+		/// \p intersecting are set to nonzero values if the box is outside of some plane or crosses some plane.
+		template <typename T, std::size_t Dim> inline void cull_block(
+			const std::vector<cull_plane<T, Dim>> &planes, std::size_t begin, std::size_t count,
+			std::uint8_t *outside, std::uint8_t *intersecting
+		) {
+			std::memset(outside, 0, count);
+			std::memset(intersecting, 0, count);
+			for (const cull_plane<T, Dim> &pl : planes) {
+				T positive_dist[cull_block_size], negative_dist[cull_block_size];
+				for (std::size_t i = 0; i < count; ++i) {
+					positive_dist[i] = negative_dist[i] = pl.offset;
+				}
+				for (std::size_t d = 0; d < Dim; ++d) {
+					const T *positive = pl.positive_lanes[d] + begin, *negative = pl.negative_lanes[d] + begin;
+					T n = pl.normal[d];
+					for (std::size_t i = 0; i < count; ++i) {
+						positive_dist[i] += n * positive[i];
+						negative_dist[i] += n * negative[i];
+					}
+				}
+				for (std::size_t i = 0; i < count; ++i) {
+					outside[i] |= static_cast<std::uint8_t>(positive_dist[i] < T{});
+					intersecting[i] |= static_cast<std::uint8_t>(negative_dist[i] < T{});
+				}
+			}
+		}
+
+		/// Culls boxes in the range [\p begin, \p end), writing indices of visible boxes to \p visible and
+		/// optionally classifications to \p classes. Returns the number of visible boxes.
+		template <typename T, std::size_t Dim> inline std::size_t cull_range(
+			const std::vector<cull_plane<T, Dim>> &planes, std::size_t begin, std::size_t end,
+			std::size_t *visible, containment *classes
+		) {
+			std::uint8_t outside[cull_block_size], intersecting[cull_block_size];
+			std::size_t num_visible = 0;
+			for (std::size_t block = begin; block < end; block += cull_block_size) {
+				std::size_t count = std::min(cull_block_size, end - block);
+				cull_block(planes, block, count, outside, intersecting);
+				if (classes) {
+					for (std::size_t i = 0; i < count; ++i) {
+						classes[block + i] =
+							outside[i] ? containment::outside :
+							intersecting[i] ? containment::intersecting :
+							containment::inside;
+					}
+				}
+				if (visible) { // branch-free compaction
+					for (std::size_t i = 0; i < count; ++i) {
+						visible[num_visible] = block + i;
+						num_visible += outside[i] ^ 1;
+					}
+				}
+			}
+			return num_visible;
+		}
+	}
+
+	/// Classifies each box against the intersection of the positive half-spaces of the given planes. Boxes
+	/// reported as \ref containment::intersecting may still be outside of the region if they are outside of
+	/// multiple planes at a corner.
+	template <typename T, std::size_t Dim> inline void classify_boxes(
+		const plane<T, Dim> *planes, std::size_t num_planes, const aabb_span<T, Dim> &boxes, containment *classes
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(cull, boxes.count(), aabb_span<T, Dim>);
+		_details::cull_range(
+			_details::prepare_cull_planes(planes, num_planes, boxes), 0, boxes.count(), nullptr, classes
+		);
+	}
+	/// Culls boxes against the given planes. Indices of boxes that are not completely outside are written to
+	/// \p visible, which must have room for all boxes. Classifications are also written to \p classes if it's not
+	/// \p nullptr.
+	///
+	/// \return The number of visible boxes.
+	template <typename T, std::size_t Dim> inline std::size_t cull_boxes(
+		const plane<T, Dim> *planes, std::size_t num_planes, const aabb_span<T, Dim> &boxes,
+		std::size_t *visible, containment *classes = nullptr
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(cull, boxes.count(), aabb_span<T, Dim>);
+		return _details::cull_range(
+			_details::prepare_cull_planes(planes, num_planes, boxes), 0, boxes.count(), visible, classes
+		);
+	}
+	/// Multithreaded version of \ref cull_boxes(). Each thread compacts indices of its own chunk of boxes, and the
+	/// chunks are then concatenated. The order of the indices is the same as \ref cull_boxes().
+	template <typename T, std::size_t Dim> inline std::size_t cull_boxes_parallel(
+		const plane<T, Dim> *planes, std::size_t num_planes, const aabb_span<T, Dim> &boxes,
+		std::size_t *visible, containment *classes = nullptr,
+		std::size_t num_threads = parallel::default_thread_count()
+	) {
+		constexpr std::size_t min_chunk_size = 16384;
+		CGMATH_INSTRUMENT_ELEMENTS(cull, boxes.count(), aabb_span<T, Dim>);
+
+		auto prepared = _details::prepare_cull_planes(planes, num_planes, boxes);
+		std::size_t num_chunks = parallel::chunk_count(boxes.count(), num_threads, min_chunk_size);
+		std::vector<std::size_t> chunk_begins(num_chunks), chunk_counts(num_chunks);
+		parallel::for_each_chunk(
+			boxes.count(), num_threads, min_chunk_size,
+			[&](std::size_t chunk, std::size_t begin, std::size_t end) {
+				chunk_begins[chunk] = begin;
+				chunk_counts[chunk] = _details::cull_range(prepared, begin, end, visible + begin, classes);
+			}
+		);
+		std::size_t num_visible = chunk_counts[0];
+		for (std::size_t i = 1; i < num_chunks; ++i) {
+			std::copy(
+				visible + chunk_begins[i], visible + chunk_begins[i] + chunk_counts[i], visible + num_visible
+			);
+			num_visible += chunk_counts[i];
+		}
+		return num_visible;
+	}
+
+	/// Classifies boxes against a frustum.
+	template <typename T> inline void classify_boxes(
+		const frustum<T> &frust, const aabb_span<T, 3> &boxes, containment *classes
+	) {
+		classify_boxes(frust.planes.data(), frust.planes.size(), boxes, classes);
+	}
+	/// Culls boxes against a frustum.
+	template <typename T> inline std::size_t cull_boxes(
+		const frustum<T> &frust, const aabb_span<T, 3> &boxes, std::size_t *visible, containment *classes = nullptr
+	) {
+		return cull_boxes(frust.planes.data(), frust.planes.size(), boxes, visible, classes);
+	}
+	/// Culls boxes against a frustum using multiple threads.
+	template <typename T> inline std::size_t cull_boxes_parallel(
+		const frustum<T> &frust, const aabb_span<T, 3> &boxes, std::size_t *visible, containment *classes = nullptr,
+		std::size_t num_threads = parallel::default_thread_count()
+	) {
+		return cull_boxes_parallel(
+			frust.planes.data(), frust.planes.size(), boxes, visible, classes, num_threads
+		);
+	}
+}
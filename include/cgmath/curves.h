@@ -0,0 +1,573 @@
+#pragma once
+
+/// \file
+/// Polynomial curves: Bezier curves, B-splines, and Catmull-Rom splines.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "vec.h"
+#include "point.h"
+#include "instrument.h"
+
+namespace math {
+	namespace _details {
+		/// The number of parameter values evaluated at a time by bulk curve evaluation. Basis functions of a
+		/// whole block are computed before they are combined, so that both loops consist of independent
+		/// iterations.
+		constexpr inline std::size_t curve_block_size = 64;
+
+		/// Computes the \p N + 1 Bernstein polynomials of degree \p N at \p t.
+		template <std::size_t N, typename T> constexpr void bernstein_basis(T t, T (&weights)[N + 1]) {
+			T s = static_cast<T>(1) - t;
+			weights[0] = static_cast<T>(1);
+			for (std::size_t j = 1; j <= N; ++j) {
+				weights[j] = t * weights[j - 1];
+				for (std::size_t k = j - 1; k > 0; --k) {
+					weights[k] = s * weights[k] + t * weights[k - 1];
+				}
+				weights[0] *= s;
+			}
+		}
+
+		/// Computes the \p Degree + 1 nonzero B-spline basis functions and their derivatives in a knot span using
+		/// the Cox-de Boor recurrence. \p left[j] and \p right[j] are the distances from the parameter to the
+		/// j-th knot to the left and to the right of the span, with index 0 unused.
+		template <std::size_t Degree, typename T> constexpr void bspline_basis(
+			const T (&left)[Degree + 1], const T (&right)[Degree + 1],
+			T (&weights)[Degree + 1], T (&derivatives)[Degree + 1]
+		) {
+			// the last level of the recurrence divides the lower-degree basis functions by the same knot
+			// differences that appear in their derivatives
+			T last[Degree + 1]{};
+			weights[0] = static_cast<T>(1);
+			for (std::size_t k = 1; k <= Degree; ++k) {
+				T saved{};
+				for (std::size_t r = 0; r < k; ++r) {
+					T temp = weights[r] / (right[r + 1] + left[k - r]);
+					last[r] = temp;
+					weights[r] = saved + right[r + 1] * temp;
+					saved = left[k - r] * temp;
+				}
+				weights[k] = saved;
+			}
+			T prev{};
+			for (std::size_t r = 0; r <= Degree; ++r) {
+				T cur = r < Degree ? last[r] : T{};
+				derivatives[r] = static_cast<T>(Degree) * (prev - cur);
+				prev = cur;
+			}
+		}
+
+		/// Returns the weighted sum of \p K consecutive control points.
+		template <typename Out, std::size_t K, typename Src, typename T> constexpr Out weighted_sum(
+			const Src *points, const T (&weights)[K]
+		) {
+			Out result;
+			for (std::size_t d = 0; d < Out::size(); ++d) {
+				T sum = weights[0] * points[0][d];
+				for (std::size_t k = 1; k < K; ++k) {
+					sum += weights[k] * points[k][d];
+				}
+				result[d] = sum;
+			}
+			return result;
+		}
+
+		/// Evaluates a curve at \p count parameter values. For each parameter, \p basis computes the weights of
+		/// \p K consecutive control points and returns the index of the first one. If \p Gather is \p false, the
+		/// first index is always zero.
+		template <
+			std::size_t K, bool Gather, typename T, typename Src, typename Out, typename Basis
+		> inline void evaluate_curve(const Src *points, const T *ts, std::size_t count, Out *out, Basis &&basis) {
+			T weights[K][curve_block_size], sums[curve_block_size], w[K];
+			std::size_t first[curve_block_size];
+			for (std::size_t begin = 0; begin < count; begin += curve_block_size) {
+				std::size_t n = std::min(curve_block_size, count - begin);
+				for (std::size_t i = 0; i < n; ++i) {
+					first[i] = basis(ts[begin + i], w);
+					for (std::size_t k = 0; k < K; ++k) {
+						weights[k][i] = w[k];
+					}
+				}
+				for (std::size_t d = 0; d < Out::size(); ++d) {
+					if constexpr (Gather) {
+						for (std::size_t i = 0; i < n; ++i) {
+							sums[i] = weights[0][i] * points[first[i]][d];
+						}
+						for (std::size_t k = 1; k < K; ++k) {
+							for (std::size_t i = 0; i < n; ++i) {
+								sums[i] += weights[k][i] * points[first[i] + k][d];
+							}
+						}
+					} else {
+						T p0 = points[0][d];
+						for (std::size_t i = 0; i < n; ++i) {
+							sums[i] = weights[0][i] * p0;
+						}
+						for (std::size_t k = 1; k < K; ++k) {
+							T pk = points[k][d];
+							for (std::size_t i = 0; i < n; ++i) {
+								sums[i] += weights[k][i] * pk;
+							}
+						}
+					}
+					for (std::size_t i = 0; i < n; ++i) {
+						out[begin + i][d] = sums[i];
+					}
+				}
+			}
+		}
+
+		/// Returns the squared distance between \p p and the segment from \p a to \p b.
+		template <typename T, std::size_t Dim> [[nodiscard]] inline T squared_distance_to_segment(
+			const point<T, Dim> &p, const point<T, Dim> &a, const point<T, Dim> &b
+		) {
+			vec<T, Dim> ab = b - a, ap = p - a;
+			T len = ab.squared_norm();
+			if (len > T{}) {
+				T t = std::clamp(vec<T, Dim>::dot(ap, ab) / len, T{}, static_cast<T>(1));
+				ap = ap - ab * t;
+			}
+			return ap.squared_norm();
+		}
+	}
+
+	/// A Bezier curve of degree \p Degree defined on [0, 1].
+	template <typename T, std::size_t Dim, std::size_t Degree> struct bezier {
+	public:
+		using value_type = T; ///< The scalar type.
+		constexpr static std::size_t degree = Degree; ///< The degree of this curve.
+
+		/// Default constructor.
+		constexpr bezier() = default;
+		/// Initializes all control points.
+		template <
+			typename ...Args, typename = std::enable_if_t<sizeof...(Args) == Degree + 1>
+		> constexpr explicit bezier(Args &&...args) : control_points{ { std::forward<Args>(args)... } } {
+		}
+
+		/// Returns the number of polynomial segments, which is always 1.
+		[[nodiscard]] constexpr static std::size_t num_segments() {
+			return 1;
+		}
+		/// Returns the parameter range of the given segment, which is always [0, 1].
+		[[nodiscard]] constexpr static std::pair<T, T> segment_domain(std::size_t) {
+			return { T{}, static_cast<T>(1) };
+		}
+
+		/// Evaluates this curve at the given parameter.
+		[[nodiscard]] constexpr point<T, Dim> evaluate(T t) const {
+			T weights[Degree + 1]{};
+			_details::bernstein_basis<Degree>(t, weights);
+			return _details::weighted_sum<point<T, Dim>>(control_points.data(), weights);
+		}
+		/// Evaluates this curve at \p count parameters.
+		void evaluate(const T *ts, std::size_t count, point<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, bezier);
+			_details::evaluate_curve<Degree + 1, false>(
+				control_points.data(), ts, count, out,
+				[](T t, T (&weights)[Degree + 1]) {
+					_details::bernstein_basis<Degree>(t, weights);
+					return static_cast<std::size_t>(0);
+				}
+			);
+		}
+
+		/// Evaluates the derivative of the given order at the given parameter.
+		template <std::size_t Order = 1> [[nodiscard]] constexpr vec<T, Dim> derivative(T t) const {
+			if constexpr (Order > Degree) {
+				return vec<T, Dim>();
+			} else {
+				std::array<vec<T, Dim>, Degree + 1 - Order> diffs = _differences<Order>();
+				T weights[Degree + 1 - Order]{};
+				_details::bernstein_basis<Degree - Order>(t, weights);
+				return _details::weighted_sum<vec<T, Dim>>(diffs.data(), weights);
+			}
+		}
+		/// Evaluates the derivative of the given order at \p count parameters.
+		template <std::size_t Order = 1> void derivative(const T *ts, std::size_t count, vec<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, bezier);
+			if constexpr (Order > Degree) {
+				std::fill(out, out + count, vec<T, Dim>());
+			} else {
+				std::array<vec<T, Dim>, Degree + 1 - Order> diffs = _differences<Order>();
+				_details::evaluate_curve<Degree + 1 - Order, false>(
+					diffs.data(), ts, count, out,
+					[](T t, T (&weights)[Degree + 1 - Order]) {
+						_details::bernstein_basis<Degree - Order>(t, weights);
+						return static_cast<std::size_t>(0);
+					}
+				);
+			}
+		}
+
+		std::array<point<T, Dim>, Degree + 1> control_points; ///< Control points.
+	private:
+		/// Returns the control points of the derivative of the given order, which is a Bezier curve of degree
+		/// \p Degree - \p Order.
+		template <std::size_t Order> [[nodiscard]] constexpr std::array<
+			vec<T, Dim>, Degree + 1 - Order
+		> _differences() const {
+			std::array<vec<T, Dim>, Degree + 1> diffs;
+			for (std::size_t i = 0; i <= Degree; ++i) {
+				diffs[i] = control_points[i].as_vec();
+			}
+			T scale = static_cast<T>(1);
+			for (std::size_t o = 0; o < Order; ++o) {
+				for (std::size_t i = 0; i < Degree - o; ++i) {
+					diffs[i] = diffs[i + 1] - diffs[i];
+				}
+				scale *= static_cast<T>(Degree - o);
+			}
+			std::array<vec<T, Dim>, Degree + 1 - Order> result;
+			for (std::size_t i = 0; i <= Degree - Order; ++i) {
+				result[i] = diffs[i] * scale;
+			}
+			return result;
+		}
+	};
+
+	/// A non-uniform B-spline of degree \p Degree. With \p n control points, the knot vector contains
+	/// \p n + \p Degree + 1 non-decreasing knots, and the curve is defined on
+	/// [knots[\p Degree], knots[\p n]].
+	template <typename T, std::size_t Dim, std::size_t Degree> struct bspline {
+	public:
+		using value_type = T; ///< The scalar type.
+		constexpr static std::size_t degree = Degree; ///< The degree of this curve.
+
+		/// Default constructor.
+		bspline() = default;
+		/// Initializes the control points and the knot vector. There must be more than \p Degree control points,
+		/// and exactly \p Degree + 1 more knots than control points.
+		bspline(std::vector<point<T, Dim>> pts, std::vector<T> knots) :
+			_points(std::move(pts)), _knots(std::move(knots)) {
+		}
+		/// Creates a clamped B-spline that starts at the first control point and ends at the last control point,
+		/// with uniformly spaced interior knots. The curve is defined on [0, n - \p Degree].
+		[[nodiscard]] static bspline clamped(std::vector<point<T, Dim>> pts) {
+			std::size_t n = pts.size();
+			std::vector<T> knots(n + Degree + 1);
+			for (std::size_t i = 0; i < knots.size(); ++i) {
+				std::size_t k = std::clamp(i, Degree, n) - Degree;
+				knots[i] = static_cast<T>(k);
+			}
+			return bspline(std::move(pts), std::move(knots));
+		}
+
+		/// Returns the control points.
+		[[nodiscard]] const std::vector<point<T, Dim>> &control_points() const {
+			return _points;
+		}
+		/// Returns the knot vector.
+		[[nodiscard]] const std::vector<T> &knots() const {
+			return _knots;
+		}
+
+		/// Returns the number of knot spans in the domain, some of which may be empty.
+		[[nodiscard]] std::size_t num_segments() const {
+			return _points.size() - Degree;
+		}
+		/// Returns the parameter range of the given knot span.
+		[[nodiscard]] std::pair<T, T> segment_domain(std::size_t i) const {
+			return { _knots[Degree + i], _knots[Degree + i + 1] };
+		}
+
+		/// Evaluates this curve at the given parameter, which is clamped into the domain.
+		[[nodiscard]] point<T, Dim> evaluate(T t) const {
+			T weights[Degree + 1], derivatives[Degree + 1];
+			std::size_t first = _basis(t, weights, derivatives);
+			return _details::weighted_sum<point<T, Dim>>(_points.data() + first, weights);
+		}
+		/// Evaluates this curve at \p count parameters.
+		void evaluate(const T *ts, std::size_t count, point<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, bspline);
+			_details::evaluate_curve<Degree + 1, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&weights)[Degree + 1]) {
+					T derivatives[Degree + 1];
+					return _basis(t, weights, derivatives);
+				}
+			);
+		}
+		/// Evaluates the first derivative at the given parameter.
+		[[nodiscard]] vec<T, Dim> derivative(T t) const {
+			T weights[Degree + 1], derivatives[Degree + 1];
+			std::size_t first = _basis(t, weights, derivatives);
+			return _details::weighted_sum<vec<T, Dim>>(_points.data() + first, derivatives);
+		}
+		/// Evaluates the first derivative at \p count parameters.
+		void derivative(const T *ts, std::size_t count, vec<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, bspline);
+			_details::evaluate_curve<Degree + 1, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&derivatives)[Degree + 1]) {
+					T weights[Degree + 1];
+					return _basis(t, weights, derivatives);
+				}
+			);
+		}
+	private:
+		std::vector<point<T, Dim>> _points; ///< Control points.
+		std::vector<T> _knots; ///< The knot vector.
+
+		/// Computes the basis functions and their derivatives, and returns the index of the first control point
+		/// they apply to.
+		std::size_t _basis(T t, T (&weights)[Degree + 1], T (&derivatives)[Degree + 1]) const {
+			std::size_t n = _points.size();
+			t = std::clamp(t, _knots[Degree], _knots[n]);
+			// the last span whose first knot is not greater than t
+			std::size_t span = static_cast<std::size_t>(
+				std::upper_bound(_knots.begin() + Degree + 1, _knots.begin() + n, t) - _knots.begin()
+			) - 1;
+			T left[Degree + 1]{}, right[Degree + 1]{};
+			for (std::size_t j = 1; j <= Degree; ++j) {
+				left[j] = t - _knots[span + 1 - j];
+				right[j] = _knots[span + j] - t;
+			}
+			_details::bspline_basis<Degree>(left, right, weights, derivatives);
+			return span - Degree;
+		}
+	};
+
+	/// A uniform B-spline of degree \p Degree, i.e., one whose knots are consecutive integers. With \p n control
+	/// points, the curve is defined on [0, n - \p Degree], and does not generally pass through any control point.
+	/// The basis functions do not depend on the knot vector, so they are evaluated without any lookups.
+	template <typename T, std::size_t Dim, std::size_t Degree> struct uniform_bspline {
+	public:
+		using value_type = T; ///< The scalar type.
+		constexpr static std::size_t degree = Degree; ///< The degree of this curve.
+
+		/// Default constructor.
+		uniform_bspline() = default;
+		/// Initializes the control points. There must be more than \p Degree control points.
+		explicit uniform_bspline(std::vector<point<T, Dim>> pts) : _points(std::move(pts)) {
+		}
+
+		/// Returns the control points.
+		[[nodiscard]] const std::vector<point<T, Dim>> &control_points() const {
+			return _points;
+		}
+
+		/// Returns the number of polynomial segments.
+		[[nodiscard]] std::size_t num_segments() const {
+			return _points.size() - Degree;
+		}
+		/// Returns the parameter range of the given segment, which is [i, i + 1].
+		[[nodiscard]] std::pair<T, T> segment_domain(std::size_t i) const {
+			return { static_cast<T>(i), static_cast<T>(i + 1) };
+		}
+
+		/// Evaluates this curve at the given parameter, which is clamped into the domain.
+		[[nodiscard]] point<T, Dim> evaluate(T t) const {
+			T weights[Degree + 1], derivatives[Degree + 1];
+			std::size_t first = _basis(t, weights, derivatives);
+			return _details::weighted_sum<point<T, Dim>>(_points.data() + first, weights);
+		}
+		/// Evaluates this curve at \p count parameters.
+		void evaluate(const T *ts, std::size_t count, point<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, uniform_bspline);
+			_details::evaluate_curve<Degree + 1, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&weights)[Degree + 1]) {
+					T derivatives[Degree + 1];
+					return _basis(t, weights, derivatives);
+				}
+			);
+		}
+		/// Evaluates the first derivative at the given parameter.
+		[[nodiscard]] vec<T, Dim> derivative(T t) const {
+			T weights[Degree + 1], derivatives[Degree + 1];
+			std::size_t first = _basis(t, weights, derivatives);
+			return _details::weighted_sum<vec<T, Dim>>(_points.data() + first, derivatives);
+		}
+		/// Evaluates the first derivative at \p count parameters.
+		void derivative(const T *ts, std::size_t count, vec<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, uniform_bspline);
+			_details::evaluate_curve<Degree + 1, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&derivatives)[Degree + 1]) {
+					T weights[Degree + 1];
+					return _basis(t, weights, derivatives);
+				}
+			);
+		}
+	private:
+		std::vector<point<T, Dim>> _points; ///< Control points.
+
+		/// Computes the basis functions and their derivatives, and returns the index of the first control point
+		/// they apply to.
+		std::size_t _basis(T t, T (&weights)[Degree + 1], T (&derivatives)[Degree + 1]) const {
+			std::size_t segments = num_segments();
+			t = std::clamp(t, T{}, static_cast<T>(segments));
+			std::size_t segment = std::min(static_cast<std::size_t>(t), segments - 1);
+			T u = t - static_cast<T>(segment);
+			T left[Degree + 1]{}, right[Degree + 1]{};
+			for (std::size_t j = 1; j <= Degree; ++j) {
+				left[j] = u + static_cast<T>(j) - static_cast<T>(1);
+				right[j] = static_cast<T>(j) - u;
+			}
+			_details::bspline_basis<Degree>(left, right, weights, derivatives);
+			return segment;
+		}
+	};
+
+	/// A uniform Catmull-Rom spline that passes through all control points. With \p n control points, the curve
+	/// is defined on [0, n - 1] and passes through the i-th control point at parameter i. The end tangents are
+	/// determined by reflecting the second and the second-to-last control points across the endpoints.
+	template <typename T, std::size_t Dim> struct catmull_rom {
+	public:
+		using value_type = T; ///< The scalar type.
+
+		/// Default constructor.
+		catmull_rom() = default;
+		/// Initializes the control points. There must be at least two control points.
+		explicit catmull_rom(const std::vector<point<T, Dim>> &pts) {
+			std::size_t n = pts.size();
+			_points.reserve(n + 2);
+			_points.emplace_back(pts[0] + (pts[0] - pts[1]));
+			_points.insert(_points.end(), pts.begin(), pts.end());
+			_points.emplace_back(pts[n - 1] + (pts[n - 1] - pts[n - 2]));
+		}
+
+		/// Returns the number of control points.
+		[[nodiscard]] std::size_t num_control_points() const {
+			return _points.size() - 2;
+		}
+		/// Returns the given control point.
+		[[nodiscard]] const point<T, Dim> &control_point(std::size_t i) const {
+			return _points[i + 1];
+		}
+
+		/// Returns the number of polynomial segments.
+		[[nodiscard]] std::size_t num_segments() const {
+			return _points.size() - 3;
+		}
+		/// Returns the parameter range of the given segment, which is [i, i + 1].
+		[[nodiscard]] std::pair<T, T> segment_domain(std::size_t i) const {
+			return { static_cast<T>(i), static_cast<T>(i + 1) };
+		}
+
+		/// Evaluates this curve at the given parameter, which is clamped into the domain.
+		[[nodiscard]] point<T, Dim> evaluate(T t) const {
+			T weights[4];
+			std::size_t first = _basis<false>(t, weights);
+			return _details::weighted_sum<point<T, Dim>>(_points.data() + first, weights);
+		}
+		/// Evaluates this curve at \p count parameters.
+		void evaluate(const T *ts, std::size_t count, point<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, catmull_rom);
+			_details::evaluate_curve<4, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&weights)[4]) {
+					return _basis<false>(t, weights);
+				}
+			);
+		}
+		/// Evaluates the first derivative at the given parameter.
+		[[nodiscard]] vec<T, Dim> derivative(T t) const {
+			T weights[4];
+			std::size_t first = _basis<true>(t, weights);
+			return _details::weighted_sum<vec<T, Dim>>(_points.data() + first, weights);
+		}
+		/// Evaluates the first derivative at \p count parameters.
+		void derivative(const T *ts, std::size_t count, vec<T, Dim> *out) const {
+			CGMATH_INSTRUMENT_ELEMENTS(curve, count, catmull_rom);
+			_details::evaluate_curve<4, true>(
+				_points.data(), ts, count, out,
+				[this](T t, T (&weights)[4]) {
+					return _basis<true>(t, weights);
+				}
+			);
+		}
+	private:
+		/// Control points, with an additional reflected point at each end.
+		std::vector<point<T, Dim>> _points;
+
+		/// Computes the weights of the four control points around the given parameter or their derivatives, and
+		/// returns the index of the first one.
+		template <bool Derivative> std::size_t _basis(T t, T (&weights)[4]) const {
+			std::size_t segments = num_segments();
+			t = std::clamp(t, T{}, static_cast<T>(segments));
+			std::size_t segment = std::min(static_cast<std::size_t>(t), segments - 1);
+			T u = t - static_cast<T>(segment), half = static_cast<T>(0.5);
+			if constexpr (Derivative) {
+				weights[0] = half * ((static_cast<T>(-3) * u + static_cast<T>(4)) * u - static_cast<T>(1));
+				weights[1] = half * (static_cast<T>(9) * u - static_cast<T>(10)) * u;
+				weights[2] = half * ((static_cast<T>(-9) * u + static_cast<T>(8)) * u + static_cast<T>(1));
+				weights[3] = half * (static_cast<T>(3) * u - static_cast<T>(2)) * u;
+			} else {
+				T u2 = u * u;
+				weights[0] = half * ((static_cast<T>(2) - u) * u - static_cast<T>(1)) * u;
+				weights[1] = half * ((static_cast<T>(3) * u - static_cast<T>(5)) * u2 + static_cast<T>(2));
+				weights[2] = half * ((static_cast<T>(-3) * u + static_cast<T>(4)) * u + static_cast<T>(1)) * u;
+				weights[3] = half * (u - static_cast<T>(1)) * u2;
+			}
+			return segment;
+		}
+	};
+
+	/// Approximates a curve with a polyline whose distance from the curve is roughly within \p tolerance, by
+	/// recursively bisecting the parameter range of each segment of the curve until the curve at the quarter
+	/// points of a range is close enough to the chord. Recursion is limited to \p MaxDepth levels and uses a
+	/// fixed-size stack. Works with all curve types in this file.
+	///
+	/// \return The output iterator after all vertices of the polyline.
+	template <std::size_t MaxDepth = 16, typename Curve, typename OutIt> inline OutIt flatten(
+		const Curve &curve, typename Curve::value_type tolerance, OutIt out
+	) {
+		using T = typename Curve::value_type;
+		using point_type = decltype(curve.evaluate(T{}));
+		struct range {
+			T begin, end;
+			point_type begin_point, end_point;
+			std::size_t depth;
+		};
+
+		T sqr_tolerance = tolerance * tolerance;
+		range stack[MaxDepth + 1];
+		bool first = true;
+		for (std::size_t seg = 0; seg < curve.num_segments(); ++seg) {
+			auto [seg_begin, seg_end] = curve.segment_domain(seg);
+			if (!(seg_begin < seg_end)) {
+				continue;
+			}
+			point_type seg_begin_point = curve.evaluate(seg_begin);
+			if (first) {
+				*out = seg_begin_point;
+				++out;
+				first = false;
+			}
+			std::size_t size = 0;
+			stack[size++] = range{ seg_begin, seg_end, seg_begin_point, curve.evaluate(seg_end), 0 };
+			while (size > 0) {
+				range cur = stack[--size];
+				T quarter = (cur.end - cur.begin) * static_cast<T>(0.25);
+				point_type mid = curve.evaluate(cur.begin + static_cast<T>(2) * quarter);
+				bool flat = cur.depth >= MaxDepth;
+				if (!flat) {
+					flat =
+						_details::squared_distance_to_segment(mid, cur.begin_point, cur.end_point) <= sqr_tolerance &&
+						_details::squared_distance_to_segment(
+							curve.evaluate(cur.begin + quarter), cur.begin_point, cur.end_point
+						) <= sqr_tolerance &&
+						_details::squared_distance_to_segment(
+							curve.evaluate(cur.end - quarter), cur.begin_point, cur.end_point
+						) <= sqr_tolerance;
+				}
+				if (flat) {
+					*out = cur.end_point;
+					++out;
+				} else { // push the second half first so that the first half is processed first
+					T mid_t = cur.begin + static_cast<T>(2) * quarter;
+					stack[size++] = range{ mid_t, cur.end, mid, cur.end_point, cur.depth + 1 };
+					stack[size++] = range{ cur.begin, mid_t, cur.begin_point, mid, cur.depth + 1 };
+				}
+			}
+		}
+		return out;
+	}
+}
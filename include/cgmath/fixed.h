@@ -0,0 +1,377 @@
+#pragma once
+
+/// \file
+/// Fixed-point numbers for deterministic arithmetic, and bulk kernels over arrays of them.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "common.h"
+#include "arithmetic.h"
+#include "instrument.h"
+#include "scalar.h"
+#include "soa.h"
+#include "impls/dot.h"
+
+namespace math {
+	namespace _details {
+#ifdef __SIZEOF_INT128__
+		__extension__ typedef __int128 fixed_int128; ///< Intermediate type of 64-bit fixed-point numbers.
+#else
+		using fixed_int128 = void; ///< 128-bit integers are not available.
+#endif
+
+		/// The storage type and the intermediate type, which is twice as wide, of fixed-point numbers with the
+		/// given number of bits.
+		template <std::size_t Bits> struct fixed_integers {
+			static_assert(Bits <= 64, "Fixed-point numbers can have at most 64 bits");
+
+			/// The storage type.
+			using storage = std::conditional_t<
+				Bits <= 16, std::int16_t, std::conditional_t<Bits <= 32, std::int32_t, std::int64_t>
+			>;
+			/// The intermediate type.
+			using wide = std::conditional_t<
+				Bits <= 16, std::int32_t, std::conditional_t<Bits <= 32, std::int64_t, fixed_int128>
+			>;
+		};
+
+		/// Block size of the bulk kernels.
+		constexpr inline std::size_t fixed_block_size = 64;
+	}
+
+	/// A signed fixed-point number with \p IntBits integer bits, including the sign bit, and \p FracBits
+	/// fractional bits. All arithmetic is carried out on integers and is therefore bit-identical on all platforms:
+	/// sums wrap around on overflow, products are computed in an integer type twice as wide and rounded to nearest
+	/// with ties rounded up, and quotients are truncated towards zero. Division by zero is undefined.
+	template <std::size_t IntBits, std::size_t FracBits> struct fixed {
+		static_assert(IntBits > 0 && FracBits > 0, "Fixed-point numbers need a sign bit and a fractional bit");
+	public:
+		/// The integer type that stores the raw value, i.e., the value multiplied by \f$ 2^{FracBits} \f$.
+		using storage_type = typename _details::fixed_integers<IntBits + FracBits>::storage;
+		/// The integer type of products and sums of products.
+		using wide_type = typename _details::fixed_integers<IntBits + FracBits>::wide;
+		static_assert(!std::is_void_v<wide_type>, "64-bit fixed-point numbers require 128-bit integers");
+
+		constexpr static std::size_t integer_bits = IntBits; ///< The number of integer bits.
+		constexpr static std::size_t fraction_bits = FracBits; ///< The number of fractional bits.
+
+		/// Default constructor. Like built-in types, the value is not initialized.
+		fixed() = default;
+		/// Conversion from integers, which must be representable.
+		template <
+			typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0
+		> constexpr explicit fixed(I value) : _raw(_wrap(static_cast<wide_type>(value) * _one)) {
+		}
+		/// Conversion from floating-point numbers, rounding to nearest. The value must be representable.
+		template <
+			typename F, std::enable_if_t<std::is_floating_point_v<F>, int> = 0
+		> constexpr explicit fixed(F value) : _raw(0) {
+			F scaled = value * static_cast<F>(_one);
+			_raw = static_cast<storage_type>(static_cast<std::int64_t>(
+				scaled < F{} ? scaled - static_cast<F>(0.5) : scaled + static_cast<F>(0.5)
+			));
+		}
+
+		/// Creates a fixed-point number from its raw value.
+		[[nodiscard]] constexpr static fixed from_raw(storage_type raw) {
+			fixed result{};
+			result._raw = raw;
+			return result;
+		}
+		/// Creates a fixed-point number from a product of two raw values, or a sum of such products, rounding to
+		/// nearest.
+		[[nodiscard]] constexpr static fixed from_product(wide_type product) {
+			// right shifts of negative values are arithmetic on all supported compilers
+			return from_raw(_wrap((product + _one / 2) >> FracBits));
+		}
+
+		/// Returns the raw value.
+		[[nodiscard]] constexpr storage_type raw() const {
+			return _raw;
+		}
+		/// Conversion to floating-point numbers, or to integers by truncating towards zero.
+		template <
+			typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0
+		> [[nodiscard]] constexpr explicit operator T() const {
+			if constexpr (std::is_floating_point_v<T>) {
+				return static_cast<T>(_raw) / static_cast<T>(_one);
+			} else {
+				return static_cast<T>(_raw / _one);
+			}
+		}
+
+		/// Unary plus.
+		[[nodiscard]] constexpr fixed operator+() const {
+			return *this;
+		}
+		/// Negation.
+		[[nodiscard]] constexpr fixed operator-() const {
+			return from_raw(_wrap(-static_cast<wide_type>(_raw)));
+		}
+
+		/// In-place addition.
+		constexpr fixed &operator+=(fixed rhs) {
+			_raw = _wrap(static_cast<wide_type>(_raw) + rhs._raw);
+			return *this;
+		}
+		/// In-place subtraction.
+		constexpr fixed &operator-=(fixed rhs) {
+			_raw = _wrap(static_cast<wide_type>(_raw) - rhs._raw);
+			return *this;
+		}
+		/// In-place multiplication.
+		constexpr fixed &operator*=(fixed rhs) {
+			_raw = from_product(static_cast<wide_type>(_raw) * rhs._raw)._raw;
+			return *this;
+		}
+		/// In-place division.
+		constexpr fixed &operator/=(fixed rhs) {
+			_raw = _wrap(static_cast<wide_type>(_raw) * _one / rhs._raw);
+			return *this;
+		}
+		/// In-place multiplication by an integer, which is exact unless the result overflows.
+		template <typename I> constexpr std::enable_if_t<std::is_integral_v<I>, fixed&> operator*=(I rhs) {
+			_raw = _wrap(static_cast<wide_type>(_raw) * static_cast<wide_type>(rhs));
+			return *this;
+		}
+		/// In-place division by an integer.
+		template <typename I> constexpr std::enable_if_t<std::is_integral_v<I>, fixed&> operator/=(I rhs) {
+			_raw = _wrap(static_cast<wide_type>(_raw) / static_cast<wide_type>(rhs));
+			return *this;
+		}
+
+		/// Addition.
+		[[nodiscard]] friend constexpr fixed operator+(fixed lhs, fixed rhs) {
+			return lhs += rhs;
+		}
+		/// Subtraction.
+		[[nodiscard]] friend constexpr fixed operator-(fixed lhs, fixed rhs) {
+			return lhs -= rhs;
+		}
+		/// Multiplication.
+		[[nodiscard]] friend constexpr fixed operator*(fixed lhs, fixed rhs) {
+			return lhs *= rhs;
+		}
+		/// Division.
+		[[nodiscard]] friend constexpr fixed operator/(fixed lhs, fixed rhs) {
+			return lhs /= rhs;
+		}
+		/// Multiplication by an integer.
+		template <typename I> [[nodiscard]] friend constexpr std::enable_if_t<
+			std::is_integral_v<I>, fixed
+		> operator*(fixed lhs, I rhs) {
+			return lhs *= rhs;
+		}
+		/// Multiplication by an integer.
+		template <typename I> [[nodiscard]] friend constexpr std::enable_if_t<
+			std::is_integral_v<I>, fixed
+		> operator*(I lhs, fixed rhs) {
+			return rhs *= lhs;
+		}
+		/// Division by an integer.
+		template <typename I> [[nodiscard]] friend constexpr std::enable_if_t<
+			std::is_integral_v<I>, fixed
+		> operator/(fixed lhs, I rhs) {
+			return lhs /= rhs;
+		}
+
+		/// Equality.
+		[[nodiscard]] friend constexpr bool operator==(fixed lhs, fixed rhs) {
+			return lhs._raw == rhs._raw;
+		}
+		/// Inequality.
+		[[nodiscard]] friend constexpr bool operator!=(fixed lhs, fixed rhs) {
+			return lhs._raw != rhs._raw;
+		}
+		/// Less than.
+		[[nodiscard]] friend constexpr bool operator<(fixed lhs, fixed rhs) {
+			return lhs._raw < rhs._raw;
+		}
+		/// Greater than.
+		[[nodiscard]] friend constexpr bool operator>(fixed lhs, fixed rhs) {
+			return lhs._raw > rhs._raw;
+		}
+		/// Less than or equal to.
+		[[nodiscard]] friend constexpr bool operator<=(fixed lhs, fixed rhs) {
+			return lhs._raw <= rhs._raw;
+		}
+		/// Greater than or equal to.
+		[[nodiscard]] friend constexpr bool operator>=(fixed lhs, fixed rhs) {
+			return lhs._raw >= rhs._raw;
+		}
+	private:
+		constexpr static wide_type _one = static_cast<wide_type>(1) << FracBits; ///< The raw value of one.
+
+		storage_type _raw; ///< The raw value.
+
+		/// Truncates an intermediate value to the storage type, wrapping around on overflow.
+		[[nodiscard]] constexpr static storage_type _wrap(wide_type value) {
+			return static_cast<storage_type>(value);
+		}
+	};
+
+	using fixed16_16 = fixed<16, 16>; ///< Shorthand for 32-bit fixed-point numbers with 16 fractional bits.
+#ifdef __SIZEOF_INT128__
+	using fixed32_32 = fixed<32, 32>; ///< Shorthand for 64-bit fixed-point numbers with 32 fractional bits.
+#endif
+
+	namespace arithmetic_traits {
+		/// Fixed-point numbers can scale vectors, and vectors of them can be compared since results are
+		/// reproducible.
+		template <std::size_t IntBits, std::size_t FracBits> struct scalar_type<fixed<IntBits, FracBits>> {
+			constexpr static bool enabled = true; ///< Enabled.
+			constexpr static bool exact = true; ///< Reproducible.
+		};
+	}
+
+	namespace impls {
+		/// Accumulates products of fixed-point numbers at full precision, and rounds only the final sum.
+		template <std::size_t IntBits, std::size_t FracBits> struct dot_accumulator<fixed<IntBits, FracBits>> {
+		public:
+			/// Adds \p l * \p r to the sum.
+			constexpr void add(fixed<IntBits, FracBits> l, fixed<IntBits, FracBits> r) {
+				_sum += static_cast<_wide_type>(l.raw()) * r.raw();
+			}
+			/// Returns the rounded sum.
+			[[nodiscard]] constexpr fixed<IntBits, FracBits> result() const {
+				return fixed<IntBits, FracBits>::from_product(_sum);
+			}
+		private:
+			using _wide_type = typename fixed<IntBits, FracBits>::wide_type; ///< The intermediate type.
+
+			_wide_type _sum = 0; ///< The sum of raw products.
+		};
+	}
+
+	namespace scalar {
+		namespace _details {
+			/// Integer square root, rounded down, using the digit-by-digit method. \p x must be non-negative.
+			template <typename T> [[nodiscard]] constexpr T integer_sqrt(T x) {
+				T result = 0, bit = static_cast<T>(1) << (sizeof(T) * 8 - 2);
+				while (bit > x) {
+					bit >>= 2;
+				}
+				for (; bit != 0; bit >>= 2) {
+					if (x >= result + bit) {
+						x -= result + bit;
+						result = (result >> 1) + bit;
+					} else {
+						result >>= 1;
+					}
+				}
+				return result;
+			}
+		}
+
+		/// Fixed-point numbers compute square roots exactly on integers.
+		template <std::size_t IntBits, std::size_t FracBits> struct traits<fixed<IntBits, FracBits>> {
+			constexpr static bool has_sqrt = true; ///< Supported.
+
+			/// Returns the square root rounded down, or zero for negative values.
+			[[nodiscard]] constexpr static fixed<IntBits, FracBits> sqrt(fixed<IntBits, FracBits> x) {
+				using wide_type = typename fixed<IntBits, FracBits>::wide_type;
+				using storage_type = typename fixed<IntBits, FracBits>::storage_type;
+				if (x.raw() <= 0) {
+					return fixed<IntBits, FracBits>::from_raw(0);
+				}
+				wide_type scaled = static_cast<wide_type>(x.raw()) * (static_cast<wide_type>(1) << FracBits);
+				return fixed<IntBits, FracBits>::from_raw(static_cast<storage_type>(_details::integer_sqrt(scaled)));
+			}
+		};
+	}
+
+	/// Bulk arithmetic over arrays of fixed-point numbers. The loops operate directly on the raw integers so that
+	/// compilers vectorize them, and produce the same bits as the scalar operators.
+	namespace fixed_kernels {
+		/// Computes \p out[i] = \p a[i] + \p b[i]. The buffers may be the same.
+		template <std::size_t IntBits, std::size_t FracBits> inline void add(
+			const fixed<IntBits, FracBits> *a, const fixed<IntBits, FracBits> *b, fixed<IntBits, FracBits> *out,
+			std::size_t count
+		) {
+			using wide_type = typename fixed<IntBits, FracBits>::wide_type;
+			using storage_type = typename fixed<IntBits, FracBits>::storage_type;
+			CGMATH_INSTRUMENT_ELEMENTS(fixed_point, count, fixed<IntBits, FracBits>);
+			for (std::size_t i = 0; i < count; ++i) {
+				out[i] = fixed<IntBits, FracBits>::from_raw(static_cast<storage_type>(
+					static_cast<wide_type>(a[i].raw()) + b[i].raw()
+				));
+			}
+		}
+		/// Computes \p out[i] = \p a[i] - \p b[i]. The buffers may be the same.
+		template <std::size_t IntBits, std::size_t FracBits> inline void subtract(
+			const fixed<IntBits, FracBits> *a, const fixed<IntBits, FracBits> *b, fixed<IntBits, FracBits> *out,
+			std::size_t count
+		) {
+			using wide_type = typename fixed<IntBits, FracBits>::wide_type;
+			using storage_type = typename fixed<IntBits, FracBits>::storage_type;
+			CGMATH_INSTRUMENT_ELEMENTS(fixed_point, count, fixed<IntBits, FracBits>);
+			for (std::size_t i = 0; i < count; ++i) {
+				out[i] = fixed<IntBits, FracBits>::from_raw(static_cast<storage_type>(
+					static_cast<wide_type>(a[i].raw()) - b[i].raw()
+				));
+			}
+		}
+		/// Computes \p out[i] = \p a[i] * \p b[i]. The buffers may be the same.
+		template <std::size_t IntBits, std::size_t FracBits> inline void multiply(
+			const fixed<IntBits, FracBits> *a, const fixed<IntBits, FracBits> *b, fixed<IntBits, FracBits> *out,
+			std::size_t count
+		) {
+			using wide_type = typename fixed<IntBits, FracBits>::wide_type;
+			CGMATH_INSTRUMENT_ELEMENTS(fixed_point, count, fixed<IntBits, FracBits>);
+			for (std::size_t i = 0; i < count; ++i) {
+				out[i] = fixed<IntBits, FracBits>::from_product(static_cast<wide_type>(a[i].raw()) * b[i].raw());
+			}
+		}
+		/// Computes \p out[i] = \p a[i] * \p s + \p b[i], e.g., to integrate positions, with the same rounding as
+		/// the scalar operators. The buffers may be the same.
+		template <std::size_t IntBits, std::size_t FracBits> inline void multiply_add(
+			const fixed<IntBits, FracBits> *a, fixed<IntBits, FracBits> s, const fixed<IntBits, FracBits> *b,
+			fixed<IntBits, FracBits> *out, std::size_t count
+		) {
+			using wide_type = typename fixed<IntBits, FracBits>::wide_type;
+			using storage_type = typename fixed<IntBits, FracBits>::storage_type;
+			CGMATH_INSTRUMENT_ELEMENTS(fixed_point, count, fixed<IntBits, FracBits>);
+			wide_type scale = s.raw();
+			for (std::size_t i = 0; i < count; ++i) {
+				wide_type product = fixed<IntBits, FracBits>::from_product(a[i].raw() * scale).raw();
+				out[i] = fixed<IntBits, FracBits>::from_raw(static_cast<storage_type>(product + b[i].raw()));
+			}
+		}
+
+		/// Computes the dot products of vectors stored in two structure-of-arrays buffers of the same size, which
+		/// are identical to the results of \ref vec::dot().
+		template <typename T, std::size_t Dim> inline void dot(
+			soa_span<T, Dim> a, soa_span<T, Dim> b, std::remove_const_t<T> *out
+		) {
+			using value_type = std::remove_const_t<T>;
+			using wide_type = typename value_type::wide_type;
+			CGMATH_INSTRUMENT_ELEMENTS(fixed_point, a.count, soa_span<T, Dim>);
+			wide_type sums[math::_details::fixed_block_size];
+			for (std::size_t begin = 0; begin < a.count; begin += math::_details::fixed_block_size) {
+				std::size_t n = std::min(math::_details::fixed_block_size, a.count - begin);
+				const value_type *a0 = a.components[0] + begin, *b0 = b.components[0] + begin;
+				for (std::size_t i = 0; i < n; ++i) {
+					sums[i] = static_cast<wide_type>(a0[i].raw()) * b0[i].raw();
+				}
+				for (std::size_t d = 1; d < Dim; ++d) {
+					const value_type *ad = a.components[d] + begin, *bd = b.components[d] + begin;
+					for (std::size_t i = 0; i < n; ++i) {
+						sums[i] += static_cast<wide_type>(ad[i].raw()) * bd[i].raw();
+					}
+				}
+				for (std::size_t i = 0; i < n; ++i) {
+					out[begin + i] = value_type::from_product(sums[i]);
+				}
+			}
+		}
+		/// Computes the squared norms of vectors stored in a structure-of-arrays buffer.
+		template <typename T, std::size_t Dim> inline void squared_norms(
+			soa_span<T, Dim> a, std::remove_const_t<T> *out
+		) {
+			dot(a, a, out);
+		}
+	}
+}
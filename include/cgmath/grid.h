@@ -0,0 +1,389 @@
+#pragma once
+
+/// \file
+/// Dynamically sized N-dimensional grids with configurable memory layouts.
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "vec.h"
+#include "point.h"
+#include "parallel.h"
+
+namespace math {
+	/// Memory layouts of \ref grid. A layout maps the coordinates of a cell to an index into the storage of the
+	/// grid, and also determines the bricks that are used for traversal. Like \ref array, the last coordinate
+	/// is the one that varies fastest in memory.
+	namespace grid_layouts {
+		namespace _details {
+			/// Returns the smallest \p n such that \f$ 2^n \geq x \f$.
+			[[nodiscard]] constexpr std::size_t ceil_log2(std::size_t x) {
+				std::size_t result = 0;
+				while ((static_cast<std::size_t>(1) << result) < x) {
+					++result;
+				}
+				return result;
+			}
+		}
+
+		/// Row-major storage without padding. Each brick is a single row along the last dimension.
+		template <std::size_t Dim> struct row_major {
+		public:
+			/// Default constructor.
+			row_major() = default;
+			/// Initializes the layout for a grid with the given extents.
+			explicit row_major(const vec<std::size_t, Dim> &extents) {
+				std::size_t stride = 1;
+				for (std::size_t d = Dim; d-- > 0; ) {
+					_strides[d] = stride;
+					stride *= extents[d];
+				}
+				_storage_size = stride;
+				for (std::size_t d = 0; d + 1 < Dim; ++d) {
+					_brick_extents[d] = 1;
+				}
+				_brick_extents[Dim - 1] = std::max<std::size_t>(extents[Dim - 1], 1); // bricks of empty grids
+			}
+
+			/// Returns the number of elements required to store the grid.
+			[[nodiscard]] std::size_t storage_size() const {
+				return _storage_size;
+			}
+			/// Returns the extents of each brick.
+			[[nodiscard]] const vec<std::size_t, Dim> &brick_extents() const {
+				return _brick_extents;
+			}
+			/// Returns the index of the given cell in the storage.
+			[[nodiscard]] std::size_t index(const vec<std::size_t, Dim> &coord) const {
+				std::size_t result = 0;
+				for (std::size_t d = 0; d < Dim; ++d) {
+					result += coord[d] * _strides[d];
+				}
+				return result;
+			}
+		private:
+			vec<std::size_t, Dim>
+				_strides, ///< The distance between consecutive cells along each dimension.
+				_brick_extents; ///< The extents of bricks.
+			std::size_t _storage_size = 0; ///< The number of elements in the storage.
+		};
+
+		/// Tiled storage: the grid is divided into bricks with \f$ 2^{BrickLog2} \f$ cells along each dimension
+		/// that are stored contiguously, so that stencils touch fewer cache lines and pages. The bricks and the
+		/// cells inside each brick are both stored in row-major order. Extents are padded to multiples of the
+		/// brick size.
+		template <std::size_t Dim, std::size_t BrickLog2 = 3> struct tiled {
+		public:
+			constexpr static std::size_t brick_size = static_cast<std::size_t>(1) << BrickLog2; ///< Brick size.
+
+			/// Default constructor.
+			tiled() = default;
+			/// Initializes the layout for a grid with the given extents.
+			explicit tiled(const vec<std::size_t, Dim> &extents) {
+				std::size_t stride = static_cast<std::size_t>(1) << (BrickLog2 * Dim);
+				for (std::size_t d = Dim; d-- > 0; ) {
+					_brick_strides[d] = stride;
+					stride *= (extents[d] + brick_size - 1) >> BrickLog2;
+					_brick_extents[d] = brick_size;
+				}
+				_storage_size = stride;
+			}
+
+			/// Returns the number of elements required to store the grid.
+			[[nodiscard]] std::size_t storage_size() const {
+				return _storage_size;
+			}
+			/// Returns the extents of each brick.
+			[[nodiscard]] const vec<std::size_t, Dim> &brick_extents() const {
+				return _brick_extents;
+			}
+			/// Returns the index of the given cell in the storage.
+			[[nodiscard]] std::size_t index(const vec<std::size_t, Dim> &coord) const {
+				constexpr std::size_t mask = brick_size - 1;
+				std::size_t brick = 0, local = 0;
+				for (std::size_t d = 0; d < Dim; ++d) {
+					brick += (coord[d] >> BrickLog2) * _brick_strides[d];
+					local = (local << BrickLog2) | (coord[d] & mask);
+				}
+				return brick + local;
+			}
+		private:
+			vec<std::size_t, Dim>
+				_brick_strides, ///< The distance between the first cells of consecutive bricks.
+				_brick_extents; ///< The extents of bricks.
+			std::size_t _storage_size = 0; ///< The number of elements in the storage.
+		};
+
+		/// Storage in Morton (Z-) order, obtained by interleaving the bits of the coordinates. Each extent is
+		/// padded to a power of two, and dimensions with fewer bits stop taking part in the interleaving once
+		/// their bits run out, so the storage is at most \f$ 2^{Dim} \f$ times the number of cells even for
+		/// elongated grids. The index is the sum of one table lookup per dimension. Every aligned block of
+		/// \f$ 2^{BrickLog2} \f$ cells along each dimension is contiguous, and such blocks are used as bricks.
+		template <std::size_t Dim, std::size_t BrickLog2 = 3> struct morton {
+		public:
+			/// Default constructor.
+			morton() = default;
+			/// Initializes the layout for a grid with the given extents.
+			explicit morton(const vec<std::size_t, Dim> &extents) {
+				std::size_t bits[Dim], max_bits = 0;
+				for (std::size_t d = 0; d < Dim; ++d) {
+					bits[d] = _details::ceil_log2(extents[d]);
+					max_bits = std::max(max_bits, bits[d]);
+					_offsets[d].assign(static_cast<std::size_t>(1) << bits[d], 0);
+					_brick_extents[d] = static_cast<std::size_t>(1) << std::min(bits[d], BrickLog2);
+				}
+				std::size_t position = 0;
+				for (std::size_t b = 0; b < max_bits; ++b) {
+					for (std::size_t d = Dim; d-- > 0; ) {
+						if (b < bits[d]) {
+							for (std::size_t c = 0; c < _offsets[d].size(); ++c) {
+								_offsets[d][c] |= ((c >> b) & 1) << position;
+							}
+							++position;
+						}
+					}
+				}
+				_storage_size = static_cast<std::size_t>(1) << position;
+			}
+
+			/// Returns the number of elements required to store the grid.
+			[[nodiscard]] std::size_t storage_size() const {
+				return _storage_size;
+			}
+			/// Returns the extents of each brick.
+			[[nodiscard]] const vec<std::size_t, Dim> &brick_extents() const {
+				return _brick_extents;
+			}
+			/// Returns the index of the given cell in the storage.
+			[[nodiscard]] std::size_t index(const vec<std::size_t, Dim> &coord) const {
+				std::size_t result = 0;
+				for (std::size_t d = 0; d < Dim; ++d) {
+					result |= _offsets[d][coord[d]];
+				}
+				return result;
+			}
+		private:
+			std::vector<std::size_t> _offsets[Dim]; ///< The interleaved bits of each coordinate.
+			vec<std::size_t, Dim> _brick_extents; ///< The extents of bricks.
+			std::size_t _storage_size = 0; ///< The number of elements in the storage.
+		};
+	}
+
+	/// A dynamically sized N-dimensional grid of cells stored on the heap, using the given
+	/// \ref grid_layouts "layout".
+	template <
+		typename T, std::size_t Dim, typename Layout = grid_layouts::row_major<Dim>
+	> struct grid {
+	public:
+		using value_type = T; ///< The type of cells.
+		using layout_type = Layout; ///< The memory layout.
+		using coord_type = vec<std::size_t, Dim>; ///< Coordinates of cells.
+		/// The minimum number of bricks processed by each thread in parallel traversals.
+		constexpr static std::size_t min_bricks_per_thread = 16;
+
+		/// Default constructor.
+		grid() = default;
+		/// Creates a grid with the given extents, and initializes all cells to the given value.
+		explicit grid(const coord_type &ext, const T &value = T{}) :
+			_layout(ext), _storage(_layout.storage_size(), value), _extents(ext) {
+		}
+
+		/// Returns the extents of this grid.
+		[[nodiscard]] const coord_type &extents() const {
+			return _extents;
+		}
+		/// Returns the total number of cells.
+		[[nodiscard]] std::size_t size() const {
+			std::size_t result = 1;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				result *= _extents[d];
+			}
+			return result;
+		}
+		/// Returns the layout of this grid.
+		[[nodiscard]] const Layout &layout() const {
+			return _layout;
+		}
+		/// Returns the underlying storage, which may contain padding depending on the layout.
+		[[nodiscard]] T *data() {
+			return _storage.data();
+		}
+		/// \overload
+		[[nodiscard]] const T *data() const {
+			return _storage.data();
+		}
+
+		/// Returns whether the given cell is inside this grid.
+		[[nodiscard]] bool contains(const point<int, Dim> &coord) const {
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if (coord[d] < 0 || static_cast<std::size_t>(coord[d]) >= _extents[d]) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/// Indexing. The cell must be inside this grid.
+		[[nodiscard]] T &operator[](const coord_type &coord) {
+			return _storage[_layout.index(coord)];
+		}
+		/// \overload
+		[[nodiscard]] const T &operator[](const coord_type &coord) const {
+			return _storage[_layout.index(coord)];
+		}
+		/// \overload
+		[[nodiscard]] T &operator[](const point<int, Dim> &coord) {
+			return (*this)[_to_coord(coord)];
+		}
+		/// \overload
+		[[nodiscard]] const T &operator[](const point<int, Dim> &coord) const {
+			return (*this)[_to_coord(coord)];
+		}
+		/// Returns the cell that is closest to the given coordinates, i.e., with coordinates clamped into this
+		/// grid. The grid must not be empty.
+		[[nodiscard]] const T &at_clamped(const point<int, Dim> &coord) const {
+			coord_type clamped;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				clamped[d] = coord[d] < 0 ? 0 : std::min(static_cast<std::size_t>(coord[d]), _extents[d] - 1);
+			}
+			return (*this)[clamped];
+		}
+
+		/// Calls \p func(coord, cell) for all cells whose coordinates differ from \p center by at most
+		/// \p radius along each dimension and that are inside this grid, including the center itself.
+		template <typename Func> void for_each_neighbor(
+			const coord_type &center, std::size_t radius, Func &&func
+		) {
+			_for_each_neighbor(*this, center, radius, func);
+		}
+		/// \overload
+		template <typename Func> void for_each_neighbor(
+			const coord_type &center, std::size_t radius, Func &&func
+		) const {
+			_for_each_neighbor(*this, center, radius, func);
+		}
+
+		/// Returns the number of bricks along each dimension.
+		[[nodiscard]] coord_type num_bricks() const {
+			coord_type result;
+			const coord_type &brick = _layout.brick_extents();
+			for (std::size_t d = 0; d < Dim; ++d) {
+				result[d] = (_extents[d] + brick[d] - 1) / brick[d];
+			}
+			return result;
+		}
+		/// Calls \p func(begin, end) for each brick of the layout concurrently, where [begin, end) is the range
+		/// of cells in the brick clipped to this grid. Different bricks may be processed by different threads,
+		/// so \p func can safely write to the cells in its own brick. \p func must not throw.
+		template <typename Func> void for_each_brick(std::size_t num_threads, Func &&func) const {
+			coord_type bricks = num_bricks();
+			std::size_t total = 1;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				total *= bricks[d];
+			}
+			const coord_type &brick = _layout.brick_extents();
+			parallel::for_each_chunk(
+				total, num_threads, min_bricks_per_thread,
+				[&](std::size_t, std::size_t begin, std::size_t end) {
+					for (std::size_t i = begin; i < end; ++i) {
+						coord_type first, last;
+						std::size_t rest = i;
+						for (std::size_t d = Dim; d-- > 0; ) {
+							first[d] = rest % bricks[d] * brick[d];
+							last[d] = std::min(first[d] + brick[d], _extents[d]);
+							rest /= bricks[d];
+						}
+						func(static_cast<const coord_type&>(first), static_cast<const coord_type&>(last));
+					}
+				}
+			);
+		}
+		/// Calls \p func(coord, cell) for all cells, one brick at a time, processing bricks concurrently.
+		template <typename Func> void for_each(std::size_t num_threads, Func &&func) {
+			_for_each(*this, num_threads, func);
+		}
+		/// \overload
+		template <typename Func> void for_each(std::size_t num_threads, Func &&func) const {
+			_for_each(*this, num_threads, func);
+		}
+	private:
+		Layout _layout; ///< The layout.
+		std::vector<T> _storage; ///< The storage.
+		coord_type _extents; ///< The extents of this grid.
+
+		/// Converts signed coordinates into unsigned coordinates.
+		[[nodiscard]] static coord_type _to_coord(const point<int, Dim> &coord) {
+			coord_type result;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				result[d] = static_cast<std::size_t>(coord[d]);
+			}
+			return result;
+		}
+
+		/// Calls \p func(coord) for all coordinates in [begin, end), with the last coordinate changing fastest.
+		template <typename Func> static void _for_each_in_box(
+			const coord_type &begin, const coord_type &end, Func &&func
+		) {
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if (begin[d] >= end[d]) {
+					return;
+				}
+			}
+			coord_type coord = begin;
+			while (true) {
+				for (coord[Dim - 1] = begin[Dim - 1]; coord[Dim - 1] < end[Dim - 1]; ++coord[Dim - 1]) {
+					func(static_cast<const coord_type&>(coord));
+				}
+				std::size_t d = Dim - 1;
+				while (true) {
+					if (d == 0) {
+						return;
+					}
+					--d;
+					if (++coord[d] < end[d]) {
+						break;
+					}
+					coord[d] = begin[d];
+				}
+			}
+		}
+		/// Implementation of \ref for_each_neighbor().
+		template <typename Grid, typename Func> static void _for_each_neighbor(
+			Grid &g, const coord_type &center, std::size_t radius, Func &func
+		) {
+			coord_type begin, end;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				begin[d] = center[d] > radius ? center[d] - radius : 0;
+				end[d] = std::min(center[d] + radius + 1, g._extents[d]);
+			}
+			_for_each_in_box(
+				begin, end,
+				[&](const coord_type &coord) {
+					func(coord, g[coord]);
+				}
+			);
+		}
+		/// Implementation of \ref for_each().
+		template <typename Grid, typename Func> static void _for_each(
+			Grid &g, std::size_t num_threads, Func &func
+		) {
+			g.for_each_brick(
+				num_threads,
+				[&](const coord_type &begin, const coord_type &end) {
+					_for_each_in_box(
+						begin, end,
+						[&](const coord_type &coord) {
+							func(coord, g[coord]);
+						}
+					);
+				}
+			);
+		}
+	};
+
+	/// Shorthand for 2D grids.
+	template <typename T, typename Layout = grid_layouts::row_major<2>> using grid2 = grid<T, 2, Layout>;
+	/// Shorthand for 3D grids.
+	template <typename T, typename Layout = grid_layouts::row_major<3>> using grid3 = grid<T, 3, Layout>;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+/// \file
+/// Transform hierarchies.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "vec.h"
+#include "affine.h"
+#include "parallel.h"
+
+namespace math {
+	/// A hierarchy of 3D transformations stored as flat structure-of-arrays buffers indexed by node. Each node
+	/// has a local translation, rotation, and scale, and its world transformation is the world transformation of
+	/// its parent composed with its local transformation. World transformations are only recomputed by
+	/// \ref update() for nodes whose local transformations or ancestors have changed, one depth level at a time.
+	template <typename T> struct transform_hierarchy {
+	public:
+		/// Indicates that a node has no parent.
+		constexpr static std::size_t no_parent = std::numeric_limits<std::size_t>::max();
+
+		/// Adds a node with identity local transformation and returns its index. The parent must already exist.
+		std::size_t add_node(std::size_t parent = no_parent) {
+			std::size_t index = _parents.size();
+			std::size_t level = parent == no_parent ? 0 : _levels[parent] + 1;
+			for (std::size_t d = 0; d < 3; ++d) {
+				_translation[d].emplace_back(T{});
+				_scale[d].emplace_back(static_cast<T>(1));
+				for (std::size_t c = 0; c < 3; ++c) {
+					_rotation[d][c].emplace_back(d == c ? static_cast<T>(1) : T{});
+				}
+			}
+			_parents.emplace_back(parent);
+			_levels.emplace_back(level);
+			_first_children.emplace_back(no_parent);
+			_next_siblings.emplace_back(parent == no_parent ? no_parent : _first_children[parent]);
+			if (parent != no_parent) {
+				_first_children[parent] = index;
+			}
+			_stamps.emplace_back(0);
+			_queued.emplace_back(0);
+			_world.emplace_back(affine<T, 3>::identity());
+			_mark_dirty(index);
+			return index;
+		}
+
+		/// Returns the number of nodes.
+		[[nodiscard]] std::size_t size() const {
+			return _parents.size();
+		}
+		/// Returns the parent of the given node, or \ref no_parent.
+		[[nodiscard]] std::size_t parent(std::size_t node) const {
+			return _parents[node];
+		}
+		/// Returns the depth of the given node. Root nodes have depth 0.
+		[[nodiscard]] std::size_t level(std::size_t node) const {
+			return _levels[node];
+		}
+
+		/// Returns the local translation of the given node.
+		[[nodiscard]] vec<T, 3> get_translation(std::size_t node) const {
+			return vec<T, 3>(_translation[0][node], _translation[1][node], _translation[2][node]);
+		}
+		/// Sets the local translation of the given node.
+		void set_translation(std::size_t node, const vec<T, 3> &translation) {
+			for (std::size_t d = 0; d < 3; ++d) {
+				_translation[d][node] = translation[d];
+			}
+			_mark_dirty(node);
+		}
+		/// Returns the local rotation of the given node as a row-major matrix.
+		[[nodiscard]] array<T, 3, 3> get_rotation(std::size_t node) const {
+			array<T, 3, 3> result;
+			for (std::size_t r = 0; r < 3; ++r) {
+				for (std::size_t c = 0; c < 3; ++c) {
+					result[r][c] = _rotation[r][c][node];
+				}
+			}
+			return result;
+		}
+		/// Sets the local rotation of the given node. The linear part of \p rotation is used.
+		void set_rotation(std::size_t node, const rigid<T, 3> &rotation) {
+			for (std::size_t r = 0; r < 3; ++r) {
+				for (std::size_t c = 0; c < 3; ++c) {
+					_rotation[r][c][node] = rotation.as_affine()[r][c];
+				}
+			}
+			_mark_dirty(node);
+		}
+		/// Returns the local scale of the given node.
+		[[nodiscard]] vec<T, 3> get_scale(std::size_t node) const {
+			return vec<T, 3>(_scale[0][node], _scale[1][node], _scale[2][node]);
+		}
+		/// Sets the local scale of the given node.
+		void set_scale(std::size_t node, const vec<T, 3> &scale) {
+			for (std::size_t d = 0; d < 3; ++d) {
+				_scale[d][node] = scale[d];
+			}
+			_mark_dirty(node);
+		}
+
+		/// Returns the local transformation of the given node, which is scaling followed by rotation and then
+		/// translation.
+		[[nodiscard]] affine<T, 3> local_transform(std::size_t node) const {
+			affine<T, 3> result;
+			for (std::size_t r = 0; r < 3; ++r) {
+				for (std::size_t c = 0; c < 3; ++c) {
+					result[r][c] = _rotation[r][c][node] * _scale[c][node];
+				}
+				result[r][3] = _translation[r][node];
+			}
+			return result;
+		}
+		/// Returns the world transformation of the given node, calling \ref update() first if there are any
+		/// pending changes.
+		[[nodiscard]] const affine<T, 3> &world_transform(std::size_t node) {
+			if (has_pending_changes()) {
+				update();
+			}
+			return _world[node];
+		}
+		/// Returns the world transformation of the given node computed by the last call to \ref update().
+		[[nodiscard]] const affine<T, 3> &cached_world_transform(std::size_t node) const {
+			return _world[node];
+		}
+		/// Returns whether any local transformation has changed since the last call to \ref update().
+		[[nodiscard]] bool has_pending_changes() const {
+			return _num_dirty > 0;
+		}
+		/// Returns the number of nodes whose local transformations have changed since the last call to
+		/// \ref update().
+		[[nodiscard]] std::size_t num_pending_changes() const {
+			return _num_dirty;
+		}
+
+		/// Recomputes the world transformations of all nodes whose local transformations or ancestors have
+		/// changed. Levels are processed in order, and the nodes of each level are processed in parallel. Small
+		/// levels run on the calling thread, and larger ones are split across workers that are kept alive between
+		/// calls, so that no threads are created per frame.
+		///
+		/// \return The number of nodes whose world transformations have been recomputed.
+		std::size_t update(std::size_t num_threads = parallel::default_thread_count()) {
+			constexpr std::size_t min_chunk_size = 4096;
+
+			std::size_t total = 0;
+			++_epoch;
+			_frontier.clear();
+			for (std::size_t level = 0; level < _dirty.size() || !_frontier.empty(); ++level) {
+				// the frontier contains children of nodes updated in the previous level; add dirty nodes
+				if (level < _dirty.size()) {
+					for (std::size_t node : _dirty[level]) {
+						if (_stamps[node] != _epoch) {
+							_stamps[node] = _epoch;
+							_frontier.emplace_back(node);
+						}
+					}
+					_dirty[level].clear();
+				}
+
+				_pool.for_each_chunk(
+					_frontier.size(), num_threads, min_chunk_size,
+					[this](std::size_t, std::size_t begin, std::size_t end) {
+						for (std::size_t i = begin; i < end; ++i) {
+							std::size_t node = _frontier[i];
+							std::size_t parent = _parents[node];
+							_world[node] = parent == no_parent ?
+								local_transform(node) : _world[parent] * local_transform(node);
+						}
+					}
+				);
+				total += _frontier.size();
+
+				_next_frontier.clear();
+				for (std::size_t node : _frontier) {
+					for (std::size_t c = _first_children[node]; c != no_parent; c = _next_siblings[c]) {
+						_stamps[c] = _epoch;
+						_next_frontier.emplace_back(c);
+					}
+				}
+				std::swap(_frontier, _next_frontier);
+			}
+			_num_dirty = 0;
+			return total;
+		}
+	private:
+		std::vector<T>
+			_translation[3], ///< Local translations.
+			_rotation[3][3], ///< Local rotations.
+			_scale[3]; ///< Local scales.
+		std::vector<std::size_t>
+			_parents, ///< The parent of each node.
+			_levels, ///< The depth of each node.
+			_first_children, ///< The first child of each node.
+			_next_siblings, ///< The next sibling of each node.
+			_frontier, ///< Nodes to update in the current level.
+			_next_frontier; ///< Nodes to update in the next level.
+		/// The last update in which each node has been scheduled, used to avoid scheduling a node twice.
+		std::vector<std::uint64_t> _stamps;
+		/// The next update for which each node has been added to \ref _dirty, used to avoid adding a node twice.
+		std::vector<std::uint64_t> _queued;
+		std::vector<affine<T, 3>> _world; ///< World transformations.
+		std::vector<std::vector<std::size_t>> _dirty; ///< Nodes with changed local transformations, by level.
+		std::size_t _num_dirty = 0; ///< The number of nodes in \ref _dirty.
+		std::uint64_t _epoch = 0; ///< The number of calls to \ref update().
+		parallel::thread_pool _pool; ///< Workers reused across levels and calls to \ref update().
+
+		/// Marks a node as having a changed local transformation.
+		void _mark_dirty(std::size_t node) {
+			if (_queued[node] == _epoch + 1) {
+				return;
+			}
+			_queued[node] = _epoch + 1;
+			std::size_t level = _levels[node];
+			if (_dirty.size() <= level) {
+				_dirty.resize(level + 1);
+			}
+			_dirty[level].emplace_back(node);
+			++_num_dirty;
+		}
+	};
+}
@@ -5,13 +5,12 @@
 
 #include <type_traits>
 
+#include "../common.h"
+
 namespace math::impls {
 	/// Used to \p static_cast this object to a derived type.
 	template <typename Derived, typename ...CastSeq> struct this_ptr {
 	private:
-		// TODO std::type_identity in C++20.
-		template <typename T> using _identity = T; ///< Identity type.
-
 		/// End of recursion.
 		template <
 			template <typename> typename Mod, typename Current
@@ -29,7 +28,7 @@ namespace math::impls {
 	public:
 		/// Non-const \p this.
 		constexpr Derived &get() {
-			return _cast_sequence<_identity, this_ptr, CastSeq...>(*this);
+			return _cast_sequence<::math::_details::identity_t, this_ptr, CastSeq...>(*this);
 		}
 		/// Const \p this.
 		constexpr const Derived &get() const {
@@ -4,9 +4,26 @@
 /// Implementation of dot products.
 
 #include "../common.h"
+#include "../instrument.h"
 #include "common.h"
 
 namespace math::impls {
+	/// Accumulates the products of a dot product. Scalar types can specialize this struct to accumulate in a wider
+	/// type and round only once.
+	template <typename T> struct dot_accumulator {
+	public:
+		/// Adds \p l * \p r to the sum.
+		constexpr void add(const T &l, const T &r) {
+			_sum += l * r;
+		}
+		/// Returns the sum.
+		[[nodiscard]] constexpr T result() const {
+			return _sum;
+		}
+	private:
+		T _sum{}; ///< The sum.
+	};
+
 	/// Dot product.
 	template <typename Derived> struct dot_op {
 	private:
@@ -14,14 +31,15 @@ namespace math::impls {
 	public:
 		/// Dot product.
 		[[nodiscard]] constexpr inline static _value_type dot(const Derived &lhs, const Derived &rhs) {
-			_value_type result{};
+			CGMATH_INSTRUMENT_CALL(dot, Derived);
+			dot_accumulator<_value_type> result;
 			arr::for_each(
 				[&result](const _value_type &l, const _value_type &r) {
-					result += l * r;
+					result.add(l, r);
 				},
 				lhs, rhs
 					);
-			return result;
+			return result.result();
 		}
 	};
 }
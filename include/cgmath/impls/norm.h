@@ -4,6 +4,8 @@
 /// Norm and normalization.
 
 #include "common.h"
+#include "../instrument.h"
+#include "../scalar.h"
 
 namespace math::impls {
 	/// Stores the result of the \p normalize() functions.
@@ -31,27 +33,29 @@ namespace math::impls {
 			return Derived::dot(_this::get(), _this::get());
 			/*return Derived::dot(static_cast<const Derived&>(*this), static_cast<const Derived&>(*this));*/
 		}
-		/// Norm.
+		/// Norm. This can be evaluated at compile time.
 		template <
-			typename T = std::conditional_t<std::is_floating_point_v<_value_type>, _value_type, void>
-		> [[nodiscard]] std::enable_if_t<!std::is_same_v<T, void>, T> norm() const {
-			return std::sqrt(static_cast<T>(squared_norm()));
+			typename T = std::conditional_t<scalar::traits<_value_type>::has_sqrt, _value_type, void>
+		> [[nodiscard]] constexpr std::enable_if_t<!std::is_same_v<T, void>, T> norm() const {
+			CGMATH_INSTRUMENT_CALL(norm, Derived);
+			return scalar::sqrt(static_cast<T>(squared_norm()));
 		}
 
 	private:
 		/// Shorthand to \p std::enable_if_t for non-template methods.
 		template <bool Value, typename Res, typename Dummy> using _enable_if_t =
 			std::enable_if_t<std::is_same_v<Dummy, void> && Value, Res>;
-		/// Shorthand to \p std::enable_if_t if the vector contains floating-point values.
-		template <typename Res, typename Dummy> using _enable_if_floating_point_t =
-			_enable_if_t<std::is_floating_point_v<_value_type>, Res, Dummy>;
+		/// Shorthand to \p std::enable_if_t if the vector contains values that support \ref scalar::sqrt().
+		template <typename Res, typename Dummy> using _enable_if_has_sqrt_t =
+			_enable_if_t<scalar::traits<_value_type>::has_sqrt, Res, Dummy>;
 	public:
-		/// Normalizes this vector without checking its length.
-		template <typename Dummy = void> [[nodiscard]] constexpr _enable_if_floating_point_t<
+		/// Normalizes this vector without checking its length. This can be evaluated at compile time.
+		template <typename Dummy = void> [[nodiscard]] constexpr _enable_if_has_sqrt_t<
 			normalization_result<Unit, _value_type>, Dummy
 		> normalized_nocheck() const {
+			CGMATH_INSTRUMENT_CALL(normalize, Derived);
 			_value_type sn = squared_norm();
-			_value_type n = std::sqrt(sn);
+			_value_type n = scalar::sqrt(sn);
 			return normalization_result<Unit, _value_type>(Unit(_this::get() / n), sn, n);
 		}
 	};
@@ -76,8 +80,8 @@ namespace math::impls {
 		}
 
 		/// Returns this vector itself.
-		normalization_result<Derived, _value_type> normalized_nocheck() const {
-			return normalization_result<Derived, _value_type>(*_this::get(), _one, _one);
+		[[nodiscard]] constexpr normalization_result<Derived, _value_type> normalized_nocheck() const {
+			return normalization_result<Derived, _value_type>(_this::get(), _one, _one);
 		}
 	};
 }
@@ -0,0 +1,291 @@
+#pragma once
+
+/// \file
+/// Opt-in operation counters. Define \p CGMATH_INSTRUMENT to count calls of operations and elements processed
+/// by batch kernels. Otherwise all hooks compile to nothing, no standard library containers are included, and
+/// \ref math::instrument::snapshot(), \ref math::instrument::reset(), and \ref math::instrument::report() do
+/// nothing, so that call sites build either way.
+///
+/// The macro must be defined consistently in all translation units of a program, since it changes the
+/// definitions of inline functions. Use the \p CGMATH_INSTRUMENT CMake option, which defines it for all targets
+/// that link to the library, or define it on the command line rather than in source files.
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "common.h"
+
+#ifdef CGMATH_INSTRUMENT
+#	include <algorithm>
+#	include <string>
+#	include <vector>
+#	include <atomic>
+#	include <memory>
+#	include <mutex>
+#	include <ostream>
+#	include <typeinfo>
+#	if __has_include(<cxxabi.h>)
+#		include <cxxabi.h>
+#		include <cstdlib>
+#		define CGMATH_INSTRUMENT_DEMANGLE // undefined at the end of this file
+#	endif
+#endif
+
+namespace math::instrument {
+	/// Instrumented operations.
+	enum class operation : unsigned char {
+		add, ///< \p operator+.
+		add_assign, ///< \p operator+=.
+		subtract, ///< \p operator-.
+		subtract_assign, ///< \p operator-=.
+		negate, ///< Unary \p operator-.
+		multiply, ///< Scalar \p operator*.
+		multiply_assign, ///< Scalar \p operator*=.
+		divide, ///< Scalar \p operator/.
+		divide_assign, ///< Scalar \p operator/=.
+		equal, ///< \p operator==.
+		transform, ///< Transformation \p operator*.
+		dot, ///< Dot products.
+		norm, ///< \p norm().
+		normalize, ///< \p normalized_nocheck().
+		sqrt, ///< \ref scalar::sqrt() evaluated at runtime.
+		bulk_transform, ///< Bulk transformation of points or vectors.
+		cull, ///< Classification or culling of boxes.
+		sample, ///< Random sampling.
+		parse, ///< Parsing of text point clouds.
+		curve, ///< Bulk evaluation of curves.
+		fixed_point, ///< Bulk fixed-point arithmetic.
+		transpose, ///< Conversion between arrays of vectors and structure-of-arrays buffers.
+		isosurface, ///< Extraction of isosurfaces, counted in grid points.
+
+		num_operations ///< The number of operations.
+	};
+
+	/// Returns the name of the given operation.
+	[[nodiscard]] inline const char *operation_name(operation op) {
+		constexpr static const char *_names[] = {
+			"operator+", "operator+=", "operator-", "operator-=", "negation", "operator*", "operator*=",
+			"operator/", "operator/=", "operator==", "transform", "dot", "norm", "normalized_nocheck", "sqrt",
+			"bulk_transform", "cull", "sample", "parse", "curve", "fixed_point", "transpose",
+			"isosurface"
+		};
+		static_assert(
+			sizeof(_names) / sizeof(*_names) == static_cast<std::size_t>(operation::num_operations),
+			"Missing operation names"
+		);
+		return _names[static_cast<std::size_t>(op)];
+	}
+
+	/// Aggregated counters of an operation on a type.
+	struct counter_entry {
+		operation op = operation::num_operations; ///< The operation.
+		const char *type_name = ""; ///< The name of the type, which stays valid until the program exits.
+		std::uint64_t
+			calls = 0, ///< The number of calls.
+			elements = 0; ///< The number of elements processed by batch kernels.
+	};
+
+#ifdef CGMATH_INSTRUMENT
+	namespace _details {
+		/// The maximum number of distinct (operation, type) pairs. Counts of additional pairs are dropped.
+		constexpr inline std::size_t max_slots = 1024;
+
+		/// Counters of all slots. Only the owning thread writes to them, so relaxed loads and stores suffice and
+		/// no read-modify-write instructions are needed on the hot path.
+		struct slot_counters {
+			std::atomic<std::uint64_t>
+				calls[max_slots]{}, ///< Call counts.
+				elements[max_slots]{}; ///< Element counts.
+		};
+
+		/// An operation on a type.
+		struct slot_info {
+			operation op = operation::num_operations; ///< The operation.
+			const std::type_info *type = nullptr; ///< The type.
+			std::unique_ptr<std::string> name; ///< The name of the type, computed on first use.
+		};
+
+		/// Global state: registered slots, live threads, and counts of threads that have exited.
+		struct registry {
+			std::mutex lock; ///< Protects all other fields.
+			std::vector<slot_info> slots; ///< Registered slots.
+			std::vector<slot_counters*> threads; ///< Counters of all live threads.
+			std::unique_ptr<slot_counters> retired = std::make_unique<slot_counters>(); ///< Exited threads.
+
+			/// Returns the global registry. It is intentionally leaked so that threads exiting during static
+			/// destruction can still access it.
+			[[nodiscard]] static registry &get() {
+				static registry *instance = new registry();
+				return *instance;
+			}
+		};
+
+		/// Per-thread counters that register themselves with the \ref registry.
+		struct thread_counters {
+			/// Registers the counters.
+			thread_counters() {
+				registry &reg = registry::get();
+				std::lock_guard<std::mutex> guard(reg.lock);
+				reg.threads.emplace_back(counters.get());
+			}
+			/// Merges the counters into the retired counters and unregisters them.
+			~thread_counters() {
+				registry &reg = registry::get();
+				std::lock_guard<std::mutex> guard(reg.lock);
+				for (std::size_t i = 0; i < max_slots; ++i) {
+					reg.retired->calls[i].fetch_add(counters->calls[i].load(std::memory_order_relaxed));
+					reg.retired->elements[i].fetch_add(counters->elements[i].load(std::memory_order_relaxed));
+				}
+				reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), counters.get()));
+			}
+
+			std::unique_ptr<slot_counters> counters = std::make_unique<slot_counters>(); ///< The counters.
+		};
+		/// Counters of the current thread.
+		inline thread_local thread_counters this_thread_counters;
+
+		/// Registers a new slot and returns its index.
+		[[nodiscard]] inline std::size_t register_slot(operation op, const std::type_info &type) {
+			registry &reg = registry::get();
+			std::lock_guard<std::mutex> guard(reg.lock);
+			slot_info &info = reg.slots.emplace_back();
+			info.op = op;
+			info.type = &type;
+			return std::min(reg.slots.size() - 1, max_slots);
+		}
+		/// Returns the slot index of the given operation on the given type.
+		template <operation Op, typename T> [[nodiscard]] inline std::size_t slot() {
+			static const std::size_t index = register_slot(Op, typeid(T));
+			return index;
+		}
+
+		/// Adds to a counter owned by the current thread.
+		inline void bump(std::atomic<std::uint64_t> &counter, std::uint64_t value) {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+		/// Records a call of an operation.
+		template <operation Op, typename T> inline void record(std::uint64_t elements) {
+			std::size_t index = slot<Op, T>();
+			if (index < max_slots) {
+				slot_counters &counters = *this_thread_counters.counters;
+				bump(counters.calls[index], 1);
+				bump(counters.elements[index], elements);
+			}
+		}
+
+		/// Returns a human-readable name of the type.
+		[[nodiscard]] inline std::string type_name(const std::type_info &type) {
+#ifdef CGMATH_INSTRUMENT_DEMANGLE
+			int status = 0;
+			char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+			if (status == 0 && demangled) {
+				std::string result = demangled;
+				std::free(demangled);
+				return result;
+			}
+#endif
+			return type.name();
+		}
+	}
+
+	/// Returns the counters aggregated over all threads, including threads that have exited. Operations that
+	/// have never been called are omitted. Call sites that should also build with instrumentation disabled can
+	/// only use \p begin(), \p end(), \p size(), and \p empty() of the result.
+	[[nodiscard]] inline std::vector<counter_entry> snapshot() {
+		_details::registry &reg = _details::registry::get();
+		std::lock_guard<std::mutex> guard(reg.lock);
+		std::vector<counter_entry> result;
+		for (std::size_t i = 0; i < reg.slots.size() && i < _details::max_slots; ++i) {
+			counter_entry entry;
+			entry.op = reg.slots[i].op;
+			entry.calls = reg.retired->calls[i].load(std::memory_order_relaxed);
+			entry.elements = reg.retired->elements[i].load(std::memory_order_relaxed);
+			for (const _details::slot_counters *counters : reg.threads) {
+				entry.calls += counters->calls[i].load(std::memory_order_relaxed);
+				entry.elements += counters->elements[i].load(std::memory_order_relaxed);
+			}
+			if (entry.calls > 0) {
+				std::unique_ptr<std::string> &name = reg.slots[i].name;
+				if (!name) {
+					name = std::make_unique<std::string>(_details::type_name(*reg.slots[i].type));
+				}
+				entry.type_name = name->c_str();
+				result.emplace_back(entry);
+			}
+		}
+		return result;
+	}
+	/// Resets all counters. Counts recorded concurrently with this call may be lost.
+	inline void reset() {
+		_details::registry &reg = _details::registry::get();
+		std::lock_guard<std::mutex> guard(reg.lock);
+		for (std::size_t i = 0; i < _details::max_slots; ++i) {
+			reg.retired->calls[i].store(0, std::memory_order_relaxed);
+			reg.retired->elements[i].store(0, std::memory_order_relaxed);
+			for (_details::slot_counters *counters : reg.threads) {
+				counters->calls[i].store(0, std::memory_order_relaxed);
+				counters->elements[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+	/// Writes all counters to the given stream, one line per operation and type.
+	inline void report(std::ostream &out) {
+		for (const counter_entry &entry : snapshot()) {
+			out << operation_name(entry.op) << " on " << entry.type_name << ": " << entry.calls << " calls";
+			if (entry.elements > 0) {
+				out << ", " << entry.elements << " elements";
+			}
+			out << "\n";
+		}
+	}
+
+/// Records a call of an operation on a type. Calls made during constant evaluation are not recorded.
+#	define CGMATH_INSTRUMENT_CALL(OP, ...) CGMATH_INSTRUMENT_ELEMENTS(OP, 0, __VA_ARGS__)
+/// Records a call of a batch kernel that processes the given number of elements.
+#	define CGMATH_INSTRUMENT_ELEMENTS(OP, COUNT, ...)                                                         \
+		do {                                                                                                 \
+			if (!::math::_details::is_constant_evaluated()) {                                                \
+				::math::instrument::_details::record<::math::instrument::operation::OP, __VA_ARGS__>(COUNT); \
+			}                                                                                                \
+		} while (false)
+#else
+	namespace _details {
+		/// An empty range of counters, returned by \ref snapshot() when instrumentation is disabled.
+		struct empty_counters {
+			/// Returns a null pointer.
+			[[nodiscard]] constexpr const counter_entry *begin() const {
+				return nullptr;
+			}
+			/// Returns a null pointer.
+			[[nodiscard]] constexpr const counter_entry *end() const {
+				return nullptr;
+			}
+			/// Returns zero.
+			[[nodiscard]] constexpr std::size_t size() const {
+				return 0;
+			}
+			/// Returns \p true.
+			[[nodiscard]] constexpr bool empty() const {
+				return true;
+			}
+		};
+	}
+
+	/// Returns an empty range since instrumentation is disabled.
+	[[nodiscard]] constexpr _details::empty_counters snapshot() {
+		return {};
+	}
+	/// Does nothing since instrumentation is disabled.
+	inline void reset() {
+	}
+	/// Does nothing since instrumentation is disabled.
+	inline void report(std::ostream&) {
+	}
+
+#	define CGMATH_INSTRUMENT_CALL(OP, ...)
+#	define CGMATH_INSTRUMENT_ELEMENTS(OP, COUNT, ...)
+#endif
+}
+
+#undef CGMATH_INSTRUMENT_DEMANGLE
@@ -0,0 +1,710 @@
+#pragma once
+
+/// \file
+/// Extraction of isosurfaces from scalar fields on regular grids: marching squares in 2D and marching cubes in 3D.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "vec.h"
+#include "point.h"
+#include "grid.h"
+#include "parallel.h"
+#include "instrument.h"
+
+namespace math {
+	namespace _details {
+		/// Corners, edges, and faces of a cell of a \p Dim-dimensional grid. Bit \p a of the index of a corner is
+		/// its offset along axis \p a. The edges along axis \p a have indices starting from \f$ a 2^{Dim-1} \f$.
+		template <std::size_t Dim> struct cell_topology {
+			constexpr static std::size_t
+				num_corners = static_cast<std::size_t>(1) << Dim, ///< The number of corners.
+				num_edges = Dim << (Dim - 1), ///< The number of edges.
+				num_faces = Dim == 2 ? 1 : 2 * Dim; ///< The number of faces. A square is its only face.
+
+			/// The corners of each face in counter-clockwise order when viewed from outside the cell. The square
+			/// is counter-clockwise in the plane of its two axes.
+			std::uint8_t face_corners[num_faces][4]{};
+			std::uint8_t face_edges[num_faces][4]{}; ///< The edge from the i-th to the (i+1)-th corner of each face.
+			std::uint8_t edge_axis[num_edges]{}; ///< The axis of each edge.
+			std::uint8_t edge_owner[num_edges]{}; ///< The corner at the start of each edge.
+			std::uint8_t edge_faces[num_edges]{}; ///< The mask of faces containing each edge.
+		};
+		/// Returns the index of the edge between the two corners.
+		template <std::size_t Dim> [[nodiscard]] constexpr std::uint8_t cell_edge(std::size_t c1, std::size_t c2) {
+			std::size_t axis = 0;
+			while (((c1 ^ c2) >> axis) != 1) {
+				++axis;
+			}
+			std::size_t owner = c1 & c2;
+			std::size_t rest = (owner & ((static_cast<std::size_t>(1) << axis) - 1)) | ((owner >> (axis + 1)) << axis);
+			return static_cast<std::uint8_t>((axis << (Dim - 1)) | rest);
+		}
+		/// Computes the \ref cell_topology.
+		template <std::size_t Dim> [[nodiscard]] constexpr cell_topology<Dim> make_cell_topology() {
+			cell_topology<Dim> result;
+			for (std::size_t e = 0; e < result.num_edges; ++e) {
+				std::size_t axis = e >> (Dim - 1), rest = e & ((static_cast<std::size_t>(1) << (Dim - 1)) - 1);
+				std::size_t low = rest & ((static_cast<std::size_t>(1) << axis) - 1);
+				result.edge_axis[e] = static_cast<std::uint8_t>(axis);
+				result.edge_owner[e] = static_cast<std::uint8_t>(low | ((rest >> axis) << (axis + 1)));
+			}
+			for (std::size_t f = 0; f < result.num_faces; ++f) {
+				std::size_t base = 0, u = 0, v = 1;
+				if constexpr (Dim == 3) { // the face perpendicular to axis f / 2 on side f % 2
+					std::size_t axis = f / 2, side = f % 2, b = (axis + 1) % 3, c = (axis + 2) % 3;
+					base = side << axis;
+					u = side ? b : c;
+					v = side ? c : b;
+				}
+				std::size_t corners[4]{
+					base, base | (1u << u), base | (1u << u) | (1u << v), base | (1u << v)
+				};
+				for (std::size_t k = 0; k < 4; ++k) {
+					result.face_corners[f][k] = static_cast<std::uint8_t>(corners[k]);
+					result.face_edges[f][k] = cell_edge<Dim>(corners[k], corners[(k + 1) % 4]);
+					result.edge_faces[result.face_edges[f][k]] |= static_cast<std::uint8_t>(1u << f);
+				}
+			}
+			return result;
+		}
+		/// The topology of squares and cubes.
+		template <std::size_t Dim> constexpr inline cell_topology<Dim> cell_topologies = make_cell_topology<Dim>();
+
+		/// The elements of the isosurface in a cell, i.e., segments in 2D or triangles in 3D, as edge indices.
+		template <std::size_t Dim> struct cell_elements {
+			constexpr static std::size_t max_elements = Dim == 2 ? 2 : 12; ///< The maximum number of elements.
+			/// Refers to the additional vertex at the centroid of the edges in \ref center.
+			constexpr static std::uint8_t center_vertex = cell_topology<Dim>::num_edges;
+
+			std::uint8_t count = 0; ///< The number of elements.
+			std::uint8_t edges[max_elements * Dim]{}; ///< The edges of all elements, or \ref center_vertex.
+			std::uint16_t center = 0; ///< The mask of edges around the additional vertex, if any.
+		};
+		/// Returns the mask of faces whose inside corners are diagonally opposite, given the mask of inside
+		/// corners.
+		template <std::size_t Dim> [[nodiscard]] constexpr std::size_t ambiguous_faces(std::size_t inside) {
+			std::size_t result = 0;
+			for (std::size_t f = 0; f < cell_topology<Dim>::num_faces; ++f) {
+				bool in[4]{};
+				for (std::size_t k = 0; k < 4; ++k) {
+					in[k] = (inside >> cell_topologies<Dim>.face_corners[f][k]) & 1;
+				}
+				if (in[0] == in[2] && in[1] == in[3] && in[0] != in[1]) {
+					result |= static_cast<std::size_t>(1) << f;
+				}
+			}
+			return result;
+		}
+		/// Triangulates a loop of edges of a cube, and appends the triangles in reverse order of the loop. Diagonals
+		/// between vertices on the same face of the cube are not allowed, since they would lie on the face and may
+		/// coincide with diagonals of the neighboring cube. Loops that cannot be triangulated this way, which only
+		/// occur when multiple faces are ambiguous, are triangulated around an additional vertex.
+		constexpr void triangulate_loop(
+			const std::uint8_t *loop, std::size_t length, cell_elements<3> &result
+		) {
+			constexpr std::size_t max_length = cell_topology<3>::num_edges;
+			const cell_topology<3> &topo = cell_topologies<3>;
+			// valid[i][j] indicates whether the polygon formed by vertices i to j and diagonal (j, i) can be
+			// triangulated, and apex[i][j] is the third vertex of the triangle on that diagonal
+			bool valid[max_length][max_length]{};
+			std::uint8_t apex[max_length][max_length]{};
+			auto diagonal = [&](std::size_t i, std::size_t j) {
+				return j == i + 1 || (i == 0 && j + 1 == length) ||
+					(topo.edge_faces[loop[i]] & topo.edge_faces[loop[j]]) == 0;
+			};
+			for (std::size_t span = 1; span < length; ++span) {
+				for (std::size_t i = 0; i + span < length; ++i) {
+					std::size_t j = i + span;
+					if (span == 1) {
+						valid[i][j] = true;
+						continue;
+					}
+					for (std::size_t k = i + 1; k < j && !valid[i][j]; ++k) {
+						if (valid[i][k] && valid[k][j] && diagonal(i, k) && diagonal(k, j)) {
+							valid[i][j] = true;
+							apex[i][j] = static_cast<std::uint8_t>(k);
+						}
+					}
+				}
+			}
+			if (!valid[0][length - 1]) { // use a fan around an additional vertex; there is at most one such loop
+				for (std::size_t i = 0; i < length; ++i) {
+					result.edges[result.count * 3] = cell_elements<3>::center_vertex;
+					result.edges[result.count * 3 + 1] = loop[(i + 1) % length];
+					result.edges[result.count * 3 + 2] = loop[i];
+					++result.count;
+					result.center |= static_cast<std::uint16_t>(1u << loop[i]);
+				}
+				return;
+			}
+			std::uint8_t stack[max_length][2]{};
+			std::size_t stack_size = 0;
+			stack[stack_size][0] = 0;
+			stack[stack_size++][1] = static_cast<std::uint8_t>(length - 1);
+			while (stack_size > 0) {
+				--stack_size;
+				std::size_t i = stack[stack_size][0], j = stack[stack_size][1];
+				if (j - i < 2) {
+					continue;
+				}
+				std::size_t k = apex[i][j];
+				result.edges[result.count * 3] = loop[i];
+				result.edges[result.count * 3 + 1] = loop[j];
+				result.edges[result.count * 3 + 2] = loop[k];
+				++result.count;
+				stack[stack_size][0] = static_cast<std::uint8_t>(i);
+				stack[stack_size++][1] = static_cast<std::uint8_t>(k);
+				stack[stack_size][0] = static_cast<std::uint8_t>(k);
+				stack[stack_size++][1] = static_cast<std::uint8_t>(j);
+			}
+		}
+		/// Computes the elements of a cell given the mask of inside corners, and the mask of ambiguous faces whose
+		/// inside corners are connected. The contour on each face keeps the inside on its left when viewed from
+		/// outside the cell, so in 3D the contours on adjacent faces chain into loops, which are triangulated with
+		/// their normals pointing outside.
+		template <std::size_t Dim> [[nodiscard]] constexpr cell_elements<Dim> triangulate_cell(
+			std::size_t inside, std::size_t connected
+		) {
+			constexpr std::uint8_t none = 0xFF;
+			const cell_topology<Dim> &topo = cell_topologies<Dim>;
+			cell_elements<Dim> result;
+			std::uint8_t next[cell_topology<Dim>::num_edges]{};
+			for (std::uint8_t &n : next) {
+				n = none;
+			}
+			for (std::size_t f = 0; f < topo.num_faces; ++f) {
+				bool in[4]{};
+				for (std::size_t k = 0; k < 4; ++k) {
+					in[k] = (inside >> topo.face_corners[f][k]) & 1;
+				}
+				for (std::size_t k = 0; k < 4; ++k) {
+					if (!in[k] || in[(k + 1) % 4]) { // contours start at edges from inside to outside corners
+						continue;
+					}
+					std::size_t end = 0;
+					if (in[(k + 2) % 4] && !in[(k + 3) % 4]) { // either cut off the inside or the outside corner
+						end = (connected >> f) & 1 ? (k + 1) % 4 : (k + 3) % 4;
+					} else {
+						while (in[end] || !in[(end + 1) % 4]) {
+							++end;
+						}
+					}
+					if constexpr (Dim == 2) {
+						result.edges[result.count * 2] = topo.face_edges[f][k];
+						result.edges[result.count * 2 + 1] = topo.face_edges[f][end];
+						++result.count;
+					} else {
+						next[topo.face_edges[f][k]] = topo.face_edges[f][end];
+					}
+				}
+			}
+			if constexpr (Dim == 3) {
+				bool visited[cell_topology<Dim>::num_edges]{};
+				for (std::size_t e = 0; e < topo.num_edges; ++e) {
+					if (next[e] == none || visited[e]) {
+						continue;
+					}
+					std::uint8_t loop[cell_topology<Dim>::num_edges]{};
+					std::size_t length = 0;
+					for (std::size_t cur = e; !visited[cur]; cur = next[cur]) {
+						visited[cur] = true;
+						loop[length++] = static_cast<std::uint8_t>(cur);
+					}
+					triangulate_loop(loop, length, result);
+				}
+			}
+			return result;
+		}
+		/// Precomputed elements of all cases of inside corners, with the inside corners of ambiguous faces
+		/// separated, and the ambiguous faces of each case.
+		template <std::size_t Dim> struct cell_table {
+			/// The number of cases.
+			constexpr static std::size_t num_cases = static_cast<std::size_t>(1) << cell_topology<Dim>::num_corners;
+
+			cell_elements<Dim> elements[num_cases]; ///< The elements of each case.
+			std::uint8_t ambiguous_faces[num_cases]{}; ///< The ambiguous faces of each case.
+		};
+		/// Computes the \ref cell_table.
+		template <std::size_t Dim> [[nodiscard]] constexpr cell_table<Dim> make_cell_table() {
+			cell_table<Dim> result;
+			for (std::size_t inside = 0; inside < result.num_cases; ++inside) {
+				result.elements[inside] = triangulate_cell<Dim>(inside, 0);
+				result.ambiguous_faces[inside] = static_cast<std::uint8_t>(ambiguous_faces<Dim>(inside));
+			}
+			return result;
+		}
+		/// The case tables of marching squares and marching cubes.
+		template <std::size_t Dim> constexpr inline cell_table<Dim> cell_tables = make_cell_table<Dim>();
+	}
+
+	/// A mesh of an isosurface: line segments in 2D or triangles in 3D. Normals point towards larger values of the
+	/// field, segments keep larger values on their right, and triangles are counter-clockwise when viewed from
+	/// the side with larger values.
+	template <typename T, std::size_t Dim> struct isosurface {
+		using element_type = array<std::uint32_t, Dim>; ///< The vertex indices of a segment or triangle.
+
+		std::vector<point<T, Dim>> vertices; ///< Vertex positions in grid coordinates.
+		std::vector<unit_vec<T, Dim>> normals; ///< Normalized gradients of the field at the vertices.
+		std::vector<element_type> elements; ///< Segments or triangles.
+	};
+
+	/// Extracts isosurfaces from scalar fields on grids using marching squares in 2D and marching cubes in 3D.
+	/// Grid points with values below the isovalue are inside. Ambiguous faces are resolved with the asymptotic
+	/// decider, which both cells sharing a face evaluate identically, so the surface has no cracks; ambiguities
+	/// in the interior of cubes are not resolved. Each grid point owns the edges towards its neighbors along the
+	/// positive axes, so the vertex on each edge is created exactly once. The grid is split along the first axis
+	/// into slabs that are extracted independently and concurrently, and that are kept so that only slabs
+	/// affected by modifications are extracted again. Vertex indices are 32-bit, and the highest bit tags edges
+	/// of the next slab, so each plane of the grid can have at most \f$ 2^{31} \f$ edges, and each slab at most
+	/// \f$ 2^{31} \f$ vertices.
+	template <typename T, std::size_t Dim> struct isosurface_extractor {
+		static_assert(Dim == 2 || Dim == 3, "Only 2D and 3D isosurfaces are supported");
+	public:
+		using coord_type = vec<std::size_t, Dim>; ///< Coordinates of grid points.
+		using element_type = typename isosurface<T, Dim>::element_type; ///< Segments or triangles.
+		/// The default number of cell layers in each slab.
+		constexpr static std::size_t default_slab_size = 8;
+
+		/// Initializes the extractor with the given number of cell layers in each slab.
+		explicit isosurface_extractor(std::size_t slab_size = default_slab_size) :
+			_slab_size(std::max<std::size_t>(slab_size, 1)) {
+		}
+
+		/// Marks the grid points in [\p begin, \p end) as modified since the last extraction. Only the range along
+		/// the first axis is taken into account.
+		void mark_dirty(const coord_type &begin, const coord_type &end) {
+			if (begin[0] >= end[0]) {
+				return;
+			}
+			// gradients use central differences, so vertices up to two layers away may change
+			std::size_t first = begin[0] < 2 ? 0 : begin[0] - 2, last = end[0] + 1;
+			for (std::size_t i = first / _slab_size; i < _slabs.size() && i * _slab_size < last; ++i) {
+				_slabs[i].dirty = true;
+			}
+		}
+		/// Marks the entire grid as modified.
+		void mark_all_dirty() {
+			_valid = false;
+		}
+
+		/// Extracts the isosurface of the given field, only processing slabs that have been marked as dirty
+		/// unless the extents of the field or the isovalue have changed. Returns the merged mesh.
+		template <typename Layout> const isosurface<T, Dim> &extract(
+			const grid<T, Dim, Layout> &field, T iso, std::size_t num_threads = parallel::default_thread_count()
+		) {
+			if (!_valid || !(field.extents() == _extents) || iso != _iso) {
+				_reset(field.extents(), iso);
+			}
+			std::vector<std::size_t> dirty;
+			for (std::size_t i = 0; i < _slabs.size(); ++i) {
+				if (_slabs[i].dirty) {
+					dirty.emplace_back(i);
+				}
+			}
+			CGMATH_INSTRUMENT_ELEMENTS(isosurface, dirty.size() * _slab_size * _plane_size, isosurface<T, Dim>);
+			parallel::for_each_chunk(
+				dirty.size(), num_threads, 1,
+				[&](std::size_t, std::size_t begin, std::size_t end) {
+					_scratch scratch;
+					for (std::size_t i = begin; i < end; ++i) {
+						_extract_slab(field, dirty[i], scratch);
+					}
+				}
+			);
+			_merge(num_threads);
+			return _surface;
+		}
+
+		/// Returns the mesh produced by the last call to \ref extract().
+		[[nodiscard]] const isosurface<T, Dim> &surface() const {
+			return _surface;
+		}
+		/// \overload
+		///
+		/// The mesh is rebuilt from the slabs by every call to \ref extract(), so it can be modified or moved from.
+		[[nodiscard]] isosurface<T, Dim> &surface() {
+			return _surface;
+		}
+	private:
+		/// Marks vertex indices that refer to the first plane of the next slab. The remaining bits store the edge,
+		/// which limits the number of edges in a plane and the number of vertices in a slab to \f$ 2^{31} \f$.
+		constexpr static std::uint32_t _external = static_cast<std::uint32_t>(1) << 31;
+		/// Marks edges without vertices.
+		constexpr static std::uint32_t _no_vertex = ~static_cast<std::uint32_t>(0);
+
+		/// The results of a slab of cells.
+		struct _slab {
+			std::vector<point<T, Dim>> vertices; ///< Vertices.
+			std::vector<unit_vec<T, Dim>> normals; ///< Normals.
+			/// Elements with indices into \ref vertices, or indices of edges on the first plane of the next slab.
+			std::vector<element_type> elements;
+			/// The edges of the first vertices of this slab, which are on its first plane, in increasing order.
+			std::vector<std::uint32_t> first_plane;
+			bool dirty = true; ///< Whether this slab needs to be extracted again.
+		};
+		/// Buffers used while extracting a slab.
+		struct _scratch {
+			std::vector<T> values[2]; ///< Field values minus the isovalue on the current and the next plane.
+			std::vector<std::uint32_t> edges[2]; ///< Vertices on the edges of the current and the next plane.
+			std::vector<std::uint32_t> axis_edges; ///< Vertices on the edges between the two planes.
+		};
+
+		isosurface<T, Dim> _surface; ///< The merged mesh.
+		std::vector<_slab> _slabs; ///< All slabs.
+		coord_type _extents; ///< The extents of the field.
+		vec<std::size_t, Dim> _plane_strides; ///< The strides of grid points in a plane along each axis.
+		std::size_t _corner_offsets[_details::cell_topology<Dim>::num_corners]{}; ///< Offsets of cell corners.
+		std::size_t _plane_size = 0; ///< The number of grid points in a plane.
+		std::size_t _slab_size = default_slab_size; ///< The number of cell layers in each slab.
+		T _iso{}; ///< The isovalue.
+		bool _valid = false; ///< Whether the slabs correspond to \ref _extents and \ref _iso.
+
+		/// Resets all slabs for a new field or isovalue.
+		void _reset(const coord_type &extents, T iso) {
+			_extents = extents;
+			_iso = iso;
+			_valid = true;
+			_plane_size = 1;
+			for (std::size_t d = Dim; d-- > 1; ) {
+				_plane_strides[d] = _plane_size;
+				_plane_size *= _extents[d];
+			}
+			for (std::size_t k = 0; k < _details::cell_topology<Dim>::num_corners; ++k) {
+				_corner_offsets[k] = 0;
+				for (std::size_t d = 1; d < Dim; ++d) {
+					_corner_offsets[k] += ((k >> d) & 1) * _plane_strides[d];
+				}
+			}
+			std::size_t layers = _extents[0] - 1;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if (_extents[d] < 2) {
+					layers = 0;
+				}
+			}
+			_slabs.clear();
+			_slabs.resize((layers + _slab_size - 1) / _slab_size);
+		}
+
+		/// Returns the index of a grid point within its plane.
+		[[nodiscard]] std::size_t _plane_index(const coord_type &coord) const {
+			std::size_t result = 0;
+			for (std::size_t d = 1; d < Dim; ++d) {
+				result += coord[d] * _plane_strides[d];
+			}
+			return result;
+		}
+		/// Calls \p func(coord) for all grid points on the given plane whose coordinates are below \p end, in
+		/// increasing order of their indices.
+		template <typename Func> static void _for_each_in_plane(
+			std::size_t layer, const coord_type &end, Func &&func
+		) {
+			coord_type coord;
+			coord[0] = layer;
+			for (std::size_t d = 1; d < Dim; ++d) {
+				if (end[d] == 0) {
+					return;
+				}
+				coord[d] = 0;
+			}
+			while (true) {
+				func(coord);
+				std::size_t d = Dim - 1;
+				for (; d > 0; --d) {
+					if (++coord[d] < end[d]) {
+						break;
+					}
+					coord[d] = 0;
+				}
+				if (d == 0) {
+					break;
+				}
+			}
+		}
+
+		/// Computes the gradient of the field using central differences, or one-sided differences on the border.
+		template <typename Layout> [[nodiscard]] vec<T, Dim> _gradient(
+			const grid<T, Dim, Layout> &field, const coord_type &coord
+		) const {
+			vec<T, Dim> result;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				coord_type low = coord, high = coord;
+				low[d] = coord[d] > 0 ? coord[d] - 1 : 0;
+				high[d] = std::min(coord[d] + 1, _extents[d] - 1);
+				result[d] = (field[high] - field[low]) / static_cast<T>(high[d] - low[d]);
+			}
+			return result;
+		}
+		/// Adds the vertex on the edge from the given grid point along the given axis, where the values minus the
+		/// isovalue are \p from and \p to, and returns its index.
+		template <typename Layout> std::uint32_t _add_vertex(
+			const grid<T, Dim, Layout> &field, const coord_type &coord, std::size_t axis, T from, T to, _slab &slab
+		) const {
+			T t = from / (from - to);
+			point<T, Dim> position;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				position[d] = static_cast<T>(coord[d]);
+			}
+			position[axis] += t;
+			coord_type other = coord;
+			++other[axis];
+			vec<T, Dim> start = _gradient(field, coord), gradient = start + (_gradient(field, other) - start) * t;
+			if (gradient.squared_norm() == T{}) { // fall back to the direction of the edge
+				for (std::size_t d = 0; d < Dim; ++d) {
+					gradient[d] = T{};
+				}
+				gradient[axis] = from < to ? static_cast<T>(1) : static_cast<T>(-1);
+			}
+			slab.vertices.emplace_back(position);
+			slab.normals.emplace_back(gradient.normalized_nocheck().result);
+			assert(slab.vertices.size() <= _external && "Too many vertices in a slab");
+			return static_cast<std::uint32_t>(slab.vertices.size() - 1);
+		}
+
+		/// Adds a vertex inside the given cell at the centroid of the vertices on the given edges, whose normal is
+		/// the gradient of the trilinear interpolant, and returns its index.
+		std::uint32_t _add_center_vertex(
+			const coord_type &coord, const T *values, std::uint16_t edges, _slab &slab
+		) const {
+			const _details::cell_topology<Dim> &topo = _details::cell_topologies<Dim>;
+			vec<T, Dim> offset;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				offset[d] = T{};
+			}
+			std::size_t count = 0;
+			for (std::size_t e = 0; e < topo.num_edges; ++e) {
+				if ((edges >> e) & 1) {
+					std::size_t owner = topo.edge_owner[e], axis = topo.edge_axis[e];
+					T from = values[owner], to = values[owner | (static_cast<std::size_t>(1) << axis)];
+					for (std::size_t d = 0; d < Dim; ++d) {
+						offset[d] += static_cast<T>((owner >> d) & 1);
+					}
+					offset[axis] += from / (from - to);
+					++count;
+				}
+			}
+			offset /= static_cast<T>(count);
+			vec<T, Dim> gradient;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				gradient[d] = T{};
+				for (std::size_t k = 0; k < topo.num_corners; ++k) {
+					T weight = (k >> d) & 1 ? values[k] : -values[k];
+					for (std::size_t other = 0; other < Dim; ++other) {
+						if (other != d) {
+							weight *= (k >> other) & 1 ? offset[other] : static_cast<T>(1) - offset[other];
+						}
+					}
+					gradient[d] += weight;
+				}
+			}
+			if (gradient.squared_norm() == T{}) {
+				for (std::size_t d = 0; d < Dim; ++d) {
+					gradient[d] = d == 0 ? static_cast<T>(1) : T{};
+				}
+			}
+			point<T, Dim> position;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				position[d] = static_cast<T>(coord[d]) + offset[d];
+			}
+			slab.vertices.emplace_back(position);
+			slab.normals.emplace_back(gradient.normalized_nocheck().result);
+			assert(slab.vertices.size() <= _external && "Too many vertices in a slab");
+			return static_cast<std::uint32_t>(slab.vertices.size() - 1);
+		}
+		/// Loads the values of a plane minus the isovalue.
+		template <typename Layout> void _load_plane(
+			const grid<T, Dim, Layout> &field, std::size_t layer, std::vector<T> &values
+		) const {
+			values.resize(_plane_size);
+			std::size_t index = 0;
+			_for_each_in_plane(layer, _extents, [&](const coord_type &coord) {
+				values[index++] = field[coord] - _iso;
+			});
+		}
+		/// Creates vertices on the edges within a plane. If \p first_plane is not \p nullptr, the edges with
+		/// vertices are recorded in it.
+		template <typename Layout> void _make_plane_vertices(
+			const grid<T, Dim, Layout> &field, std::size_t layer, const std::vector<T> &values,
+			std::vector<std::uint32_t> &edges, _slab &slab, std::vector<std::uint32_t> *first_plane
+		) const {
+			edges.assign(_plane_size * (Dim - 1), _no_vertex);
+			_for_each_in_plane(layer, _extents, [&](const coord_type &coord) {
+				std::size_t index = _plane_index(coord);
+				for (std::size_t axis = 1; axis < Dim; ++axis) {
+					if (coord[axis] + 1 >= _extents[axis]) {
+						continue;
+					}
+					T from = values[index], to = values[index + _plane_strides[axis]];
+					if ((from < T{}) != (to < T{})) {
+						std::size_t edge = index * (Dim - 1) + axis - 1;
+						edges[edge] = _add_vertex(field, coord, axis, from, to, slab);
+						if (first_plane) {
+							first_plane->emplace_back(static_cast<std::uint32_t>(edge));
+						}
+					}
+				}
+			});
+		}
+		/// Creates vertices on the edges between two planes.
+		template <typename Layout> void _make_axis_vertices(
+			const grid<T, Dim, Layout> &field, std::size_t layer, _scratch &scratch, _slab &slab
+		) const {
+			scratch.axis_edges.assign(_plane_size, _no_vertex);
+			_for_each_in_plane(layer, _extents, [&](const coord_type &coord) {
+				std::size_t index = _plane_index(coord);
+				T from = scratch.values[0][index], to = scratch.values[1][index];
+				if ((from < T{}) != (to < T{})) {
+					scratch.axis_edges[index] = _add_vertex(field, coord, 0, from, to, slab);
+				}
+			});
+		}
+		/// Creates the elements of all cells between two planes.
+		void _make_cells(std::size_t layer, const _scratch &scratch, _slab &slab) const {
+			using topology = _details::cell_topology<Dim>;
+			const topology &topo = _details::cell_topologies<Dim>;
+			const _details::cell_table<Dim> &table = _details::cell_tables<Dim>;
+			coord_type end = _extents;
+			for (std::size_t d = 1; d < Dim; ++d) {
+				--end[d];
+			}
+			_for_each_in_plane(layer, end, [&](const coord_type &coord) {
+				std::size_t index = _plane_index(coord), inside = 0;
+				T values[topology::num_corners];
+				for (std::size_t k = 0; k < topology::num_corners; ++k) {
+					values[k] = scratch.values[k & 1][index + _corner_offsets[k]];
+					if (values[k] < T{}) {
+						inside |= static_cast<std::size_t>(1) << k;
+					}
+				}
+				if (inside == 0 || inside == table.num_cases - 1) {
+					return;
+				}
+				const _details::cell_elements<Dim> *elements = &table.elements[inside];
+				_details::cell_elements<Dim> resolved;
+				if (std::size_t ambiguous = table.ambiguous_faces[inside]) {
+					// asymptotic decider: the inside corners are connected if the saddle point of the bilinear
+					// interpolant is inside, which reduces to comparing the products of diagonal values
+					std::size_t connected = 0;
+					for (std::size_t f = 0; f < topology::num_faces; ++f) {
+						if ((ambiguous >> f) & 1) {
+							const std::uint8_t *corners = topo.face_corners[f];
+							T diagonal0 = values[corners[0]] * values[corners[2]];
+							T diagonal1 = values[corners[1]] * values[corners[3]];
+							bool first_inside = (inside >> corners[0]) & 1;
+							if (first_inside ? diagonal0 > diagonal1 : diagonal1 > diagonal0) {
+								connected |= static_cast<std::size_t>(1) << f;
+							}
+						}
+					}
+					if (connected != 0) {
+						resolved = _details::triangulate_cell<Dim>(inside, connected);
+						elements = &resolved;
+					}
+				}
+				std::uint32_t center = _no_vertex;
+				if (elements->center != 0) {
+					center = _add_center_vertex(coord, values, elements->center, slab);
+				}
+				for (std::size_t i = 0; i < elements->count; ++i) {
+					element_type element;
+					for (std::size_t j = 0; j < Dim; ++j) {
+						std::size_t edge = elements->edges[i * Dim + j];
+						if (edge == _details::cell_elements<Dim>::center_vertex) {
+							element[j] = center;
+							continue;
+						}
+						std::size_t axis = topo.edge_axis[edge], owner = topo.edge_owner[edge];
+						std::size_t point = index + _corner_offsets[owner];
+						element[j] = axis == 0 ?
+							scratch.axis_edges[point] :
+							scratch.edges[owner & 1][point * (Dim - 1) + axis - 1];
+					}
+					slab.elements.emplace_back(element);
+				}
+			});
+		}
+
+		/// Extracts the given slab.
+		template <typename Layout> void _extract_slab(
+			const grid<T, Dim, Layout> &field, std::size_t index, _scratch &scratch
+		) {
+			_slab &slab = _slabs[index];
+			slab.vertices.clear();
+			slab.normals.clear();
+			slab.elements.clear();
+			slab.first_plane.clear();
+			std::size_t first = index * _slab_size, last = std::min(first + _slab_size, _extents[0] - 1);
+			bool owns_last_plane = index + 1 == _slabs.size();
+
+			_load_plane(field, first, scratch.values[0]);
+			_make_plane_vertices(field, first, scratch.values[0], scratch.edges[0], slab, &slab.first_plane);
+			for (std::size_t layer = first; layer < last; ++layer) {
+				_load_plane(field, layer + 1, scratch.values[1]);
+				if (layer + 1 < last || owns_last_plane) {
+					_make_plane_vertices(field, layer + 1, scratch.values[1], scratch.edges[1], slab, nullptr);
+				} else { // vertices on the last plane belong to the next slab
+					scratch.edges[1].resize(_plane_size * (Dim - 1));
+					assert(scratch.edges[1].size() <= _external && "Too many edges in a plane");
+					for (std::size_t i = 0; i < scratch.edges[1].size(); ++i) {
+						scratch.edges[1][i] = _external | static_cast<std::uint32_t>(i);
+					}
+				}
+				_make_axis_vertices(field, layer, scratch, slab);
+				_make_cells(layer, scratch, slab);
+				std::swap(scratch.values[0], scratch.values[1]);
+				std::swap(scratch.edges[0], scratch.edges[1]);
+			}
+			slab.dirty = false;
+		}
+
+		/// Merges the results of all slabs into \ref _surface.
+		void _merge(std::size_t num_threads) {
+			std::vector<std::size_t> vertex_offsets(_slabs.size() + 1, 0), element_offsets(_slabs.size() + 1, 0);
+			_surface.vertices.clear();
+			_surface.normals.clear();
+			for (std::size_t i = 0; i < _slabs.size(); ++i) {
+				const _slab &slab = _slabs[i];
+				vertex_offsets[i + 1] = vertex_offsets[i] + slab.vertices.size();
+				element_offsets[i + 1] = element_offsets[i] + slab.elements.size();
+				_surface.vertices.insert(_surface.vertices.end(), slab.vertices.begin(), slab.vertices.end());
+				_surface.normals.insert(_surface.normals.end(), slab.normals.begin(), slab.normals.end());
+			}
+			_surface.elements.resize(element_offsets.back());
+			parallel::for_each_chunk(
+				_slabs.size(), num_threads, 1,
+				[&](std::size_t, std::size_t begin, std::size_t end) {
+					for (std::size_t i = begin; i < end; ++i) {
+						element_type *out = _surface.elements.data() + element_offsets[i];
+						for (const element_type &element : _slabs[i].elements) {
+							for (std::size_t j = 0; j < Dim; ++j) {
+								std::uint32_t vertex = element[j];
+								if (vertex & _external) {
+									const std::vector<std::uint32_t> &next = _slabs[i + 1].first_plane;
+									auto it = std::lower_bound(next.begin(), next.end(), vertex & ~_external);
+									(*out)[j] = static_cast<std::uint32_t>(vertex_offsets[i + 1] + (it - next.begin()));
+								} else {
+									(*out)[j] = static_cast<std::uint32_t>(vertex_offsets[i] + vertex);
+								}
+							}
+							++out;
+						}
+					}
+				}
+			);
+		}
+	};
+
+	/// Extracts the isosurface of the given field using a temporary \ref isosurface_extractor.
+	template <typename T, std::size_t Dim, typename Layout> [[nodiscard]] inline isosurface<T, Dim> extract_isosurface(
+		const grid<T, Dim, Layout> &field, T iso, std::size_t num_threads = parallel::default_thread_count()
+	) {
+		isosurface_extractor<T, Dim> extractor;
+		extractor.extract(field, iso, num_threads);
+		return std::move(extractor.surface());
+	}
+}
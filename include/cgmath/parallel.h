@@ -0,0 +1,177 @@
+#pragma once
+
+/// \file
+/// Minimal helpers for splitting work across threads.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace math::parallel {
+	/// Returns the default number of threads to use, which is at least 1.
+	[[nodiscard]] inline std::size_t default_thread_count() {
+		return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	/// Returns the number of chunks that \ref for_each_chunk() splits \p count elements into.
+	[[nodiscard]] constexpr std::size_t chunk_count(
+		std::size_t count, std::size_t num_threads, std::size_t min_chunk_size
+	) {
+		std::size_t min_size = std::max<std::size_t>(min_chunk_size, 1);
+		std::size_t max_chunks = (count + min_size - 1) / min_size;
+		return std::max<std::size_t>(std::min(num_threads, max_chunks), 1);
+	}
+
+	/// Returns the first element of the given chunk when \p count elements are split into \p chunks chunks.
+	[[nodiscard]] constexpr std::size_t chunk_begin(std::size_t count, std::size_t chunks, std::size_t index) {
+		return count / chunks * index + std::min(index, count % chunks);
+	}
+
+	/// Splits [0, \p count) into \ref chunk_count() contiguous chunks of roughly equal sizes, and calls
+	/// \p func(chunk_index, begin, end) for each chunk concurrently. The calling thread processes the first chunk
+	/// and waits for all other chunks to finish. \p func must not throw.
+	template <typename Func> inline void for_each_chunk(
+		std::size_t count, std::size_t num_threads, std::size_t min_chunk_size, Func &&func
+	) {
+		std::size_t chunks = chunk_count(count, num_threads, min_chunk_size);
+		std::vector<std::thread> threads;
+		threads.reserve(chunks - 1);
+		for (std::size_t i = 1; i < chunks; ++i) {
+			threads.emplace_back(
+				[&func, i, begin = chunk_begin(count, chunks, i), end = chunk_begin(count, chunks, i + 1)]() {
+					func(i, begin, end);
+				}
+			);
+		}
+		func(static_cast<std::size_t>(0), static_cast<std::size_t>(0), chunk_begin(count, chunks, 1));
+		for (std::thread &t : threads) {
+			t.join();
+		}
+	}
+
+	namespace _details {
+		/// Shared state of a \ref thread_pool and its workers.
+		struct pool_state {
+			std::mutex lock; ///< Protects all other fields.
+			std::condition_variable
+				start, ///< Notified when a job is submitted or the pool is destroyed.
+				done; ///< Notified when all chunks of the job have finished.
+			std::vector<std::thread> workers; ///< Worker threads.
+			void (*job)(void*, std::size_t) = nullptr; ///< Processes the chunk with the given index.
+			void *context = nullptr; ///< The first argument of \ref job.
+			std::size_t
+				num_chunks = 0, ///< The number of chunks of the current job.
+				next_chunk = 0, ///< The next chunk to be claimed.
+				remaining = 0; ///< The number of chunks that have not finished.
+			bool stopping = false; ///< Whether workers should exit.
+
+			/// Stops and joins all workers.
+			~pool_state() {
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					stopping = true;
+				}
+				start.notify_all();
+				for (std::thread &worker : workers) {
+					worker.join();
+				}
+			}
+
+			/// Claims and processes the next chunk. The lock is released while the chunk is processed.
+			void run_chunk(std::unique_lock<std::mutex> &guard) {
+				std::size_t index = next_chunk++;
+				void (*cur_job)(void*, std::size_t) = job;
+				void *cur_context = context;
+				guard.unlock();
+				cur_job(cur_context, index);
+				guard.lock();
+				if (--remaining == 0) {
+					done.notify_all();
+				}
+			}
+			/// The main loop of worker threads.
+			void work() {
+				std::unique_lock<std::mutex> guard(lock);
+				while (true) {
+					start.wait(guard, [this]() {
+						return stopping || next_chunk < num_chunks;
+					});
+					if (stopping) {
+						return;
+					}
+					run_chunk(guard);
+				}
+			}
+		};
+	}
+
+	/// Worker threads that are kept alive between calls to \ref for_each_chunk(), for work that is submitted
+	/// repeatedly, e.g., every frame. Workers are started on demand. Copies do not share workers with the
+	/// original. A pool must not be used by multiple threads at the same time.
+	struct thread_pool {
+	public:
+		/// Creates a pool without workers.
+		thread_pool() = default;
+		/// Creates another pool without workers.
+		thread_pool(const thread_pool&) {
+		}
+		/// Default move constructor.
+		thread_pool(thread_pool&&) noexcept = default;
+		/// Keeps the workers of this pool.
+		thread_pool &operator=(const thread_pool&) {
+			return *this;
+		}
+		/// Default move assignment.
+		thread_pool &operator=(thread_pool&&) noexcept = default;
+
+		/// Returns the number of workers that have been started.
+		[[nodiscard]] std::size_t num_workers() const {
+			return _state ? _state->workers.size() : 0;
+		}
+
+		/// Same as \ref parallel::for_each_chunk(), but chunks are processed by the workers of this pool and the
+		/// calling thread. Work that fits in a single chunk runs on the calling thread without waking any worker.
+		template <typename Func> void for_each_chunk(
+			std::size_t count, std::size_t num_threads, std::size_t min_chunk_size, Func &&func
+		) {
+			std::size_t chunks = chunk_count(count, num_threads, min_chunk_size);
+			if (chunks == 1) {
+				func(static_cast<std::size_t>(0), static_cast<std::size_t>(0), count);
+				return;
+			}
+			if (!_state) {
+				_state = std::make_unique<_details::pool_state>();
+			}
+			_details::pool_state &state = *_state;
+			auto process = [&](std::size_t i) {
+				func(i, chunk_begin(count, chunks, i), chunk_begin(count, chunks, i + 1));
+			};
+			std::unique_lock<std::mutex> guard(state.lock);
+			while (state.workers.size() + 1 < chunks) {
+				state.workers.emplace_back([&state]() {
+					state.work();
+				});
+			}
+			state.job = [](void *context, std::size_t i) {
+				(*static_cast<decltype(process)*>(context))(i);
+			};
+			state.context = &process;
+			state.num_chunks = chunks;
+			state.next_chunk = 0;
+			state.remaining = chunks;
+			state.start.notify_all();
+			while (state.next_chunk < state.num_chunks) {
+				state.run_chunk(guard);
+			}
+			state.done.wait(guard, [&state]() {
+				return state.remaining == 0;
+			});
+		}
+	private:
+		std::unique_ptr<_details::pool_state> _state; ///< The shared state, created when first needed.
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/// \file
+/// Planes, or hyperplanes in general.
+
+#include "vec.h"
+#include "point.h"
+
+namespace math {
+	/// A hyperplane defined by a unit normal and an offset. Points \p p with \p dot(normal, p) + offset >= 0 are
+	/// considered to be in front of the plane.
+	template <typename T, std::size_t Dim> struct plane {
+		/// No default constructor.
+		plane() = delete;
+		/// Initializes all fields of this struct.
+		constexpr plane(const unit_vec<T, Dim> &n, T off) : normal(n), offset(std::move(off)) {
+		}
+
+		/// Creates a plane that goes through the given point.
+		[[nodiscard]] constexpr static plane from_point_normal(const point<T, Dim> &p, const unit_vec<T, Dim> &n) {
+			return plane(n, -vec<T, Dim>::dot(n, p.as_vec()));
+		}
+
+		/// Returns the signed distance from the given point to this plane.
+		[[nodiscard]] constexpr T signed_distance(const point<T, Dim> &p) const {
+			return vec<T, Dim>::dot(normal, p.as_vec()) + offset;
+		}
+		/// Returns the plane facing the opposite direction.
+		[[nodiscard]] constexpr plane flipped() const {
+			return plane(-normal, -offset);
+		}
+
+		unit_vec<T, Dim> normal; ///< The normal of this plane.
+		T offset{}; ///< The offset of this plane.
+	};
+
+	template <typename T> using plane2 = plane<T, 2>; ///< Shorthand for 2D lines.
+	using plane2f = plane2<float>; ///< Shorthand for 2D \p float lines.
+	using plane2d = plane2<double>; ///< Shorthand for 2D \p double lines.
+
+	template <typename T> using plane3 = plane<T, 3>; ///< Shorthand for 3D planes.
+	using plane3f = plane3<float>; ///< Shorthand for 3D \p float planes.
+	using plane3d = plane3<double>; ///< Shorthand for 3D \p double planes.
+}
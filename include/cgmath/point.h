@@ -15,14 +15,12 @@ namespace math {
 		template <typename T> struct typed_point {
 			template <std::size_t Dim> using type = point<T, Dim>; ///< The corresponding \ref point type.
 		};
-		/// Shorthand for \ref typed_vec::type.
-		template <typename T> using typed_point_t = typename typed_point<T>::type;
 	}
 
 	/// A point in space.
 	template <typename T, std::size_t Dim> struct point :
 		public array<T, Dim>,
-		public impls::swizzle_op<_details::typed_point_t<T>, Dim> {
+		public impls::swizzle_op<_details::typed_point<T>::template type, Dim> {
 
 	public:
 		/// Default constructor.
@@ -72,7 +70,7 @@ namespace math {
 
 		/// \ref point == \ref point.
 		template <typename T, std::size_t Dim> struct equality<point<T, Dim>, point<T, Dim>> {
-			constexpr static bool enabled = std::is_integral_v<T>; ///< Only enable for integers.
+			constexpr static bool enabled = scalar_type<T>::exact; ///< Only enable for exact types.
 		};
 	}
 
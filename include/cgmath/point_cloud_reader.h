@@ -0,0 +1,373 @@
+#pragma once
+
+/// \file
+/// Streaming parser for text point clouds.
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "point.h"
+#include "soa.h"
+#include "parallel.h"
+#include "instrument.h"
+
+namespace math {
+	/// Supported text point cloud formats.
+	enum class point_cloud_format : unsigned char {
+		xyz, ///< One point per line. Extra columns are ignored, and lines starting with \p # are comments.
+		ply, ///< ASCII PLY. Only the \p x, \p y, \p z, and \p w properties of vertices are read.
+		obj ///< Wavefront OBJ. Only \p v lines are read.
+	};
+
+	/// Reads points from a text stream in chunks of bounded size. Each chunk is split into ranges at line
+	/// boundaries, and the ranges are parsed in parallel directly into the output buffer.
+	template <typename T, std::size_t Dim> struct point_cloud_reader {
+	public:
+		/// The default number of bytes that each thread parses at a time.
+		constexpr static std::size_t default_chunk_size = static_cast<std::size_t>(1) << 20;
+
+		/// Initializes the reader. For PLY files, this reads the header from the stream.
+		explicit point_cloud_reader(
+			std::istream &in, point_cloud_format fmt,
+			std::size_t num_threads = parallel::default_thread_count(),
+			std::size_t chunk_size = default_chunk_size
+		) :
+			_input(&in),
+			_num_threads(std::max<std::size_t>(num_threads, 1)),
+			_chunk_size(std::max<std::size_t>(chunk_size, 64)),
+			_format(fmt) {
+
+			_buffer.resize(_chunk_size * _num_threads);
+			switch (_format) {
+			case point_cloud_format::xyz:
+				_set_consecutive_columns(0);
+				break;
+			case point_cloud_format::obj:
+				_set_consecutive_columns(1);
+				break;
+			case point_cloud_format::ply:
+				_read_ply_header();
+				break;
+			}
+		}
+
+		/// Reads up to \p max_points points. The return value is less than \p max_points only if the end of the
+		/// input has been reached.
+		std::size_t read(point<T, Dim> *out, std::size_t max_points) {
+			return _read(
+				max_points,
+				[out](std::size_t i, const T (&coords)[Dim]) {
+					for (std::size_t d = 0; d < Dim; ++d) {
+						out[i][d] = coords[d];
+					}
+				}
+			);
+		}
+		/// Reads up to \p out.count points into a structure-of-arrays buffer.
+		std::size_t read(const soa_span<T, Dim> &out) {
+			return _read(
+				out.count,
+				[&out](std::size_t i, const T (&coords)[Dim]) {
+					for (std::size_t d = 0; d < Dim; ++d) {
+						out.components[d][i] = coords[d];
+					}
+				}
+			);
+		}
+		/// Reads all remaining points.
+		[[nodiscard]] std::vector<point<T, Dim>> read_all() {
+			std::vector<point<T, Dim>> result;
+			std::size_t batch = _chunk_size / 16;
+			while (!eof()) {
+				std::size_t old_size = result.size();
+				result.resize(old_size + batch);
+				result.resize(old_size + read(result.data() + old_size, batch));
+			}
+			return result;
+		}
+
+		/// Returns whether all points have been read.
+		[[nodiscard]] bool eof() const {
+			return _remaining == 0 || (_input_exhausted && _data_begin == _data_end);
+		}
+		/// Returns whether any malformed data has been encountered. Coordinates that cannot be parsed are set to
+		/// \p NaN for floating-point types and zero otherwise.
+		[[nodiscard]] bool failed() const {
+			return _failed;
+		}
+	private:
+		/// Sentinel value for columns that are not read.
+		constexpr static std::size_t _unused_column = Dim;
+
+		std::vector<char> _buffer; ///< Buffered input.
+		/// For each column, the corresponding dimension or \ref _unused_column.
+		std::vector<std::size_t> _column_dims;
+		std::istream *_input = nullptr; ///< The input stream.
+		std::size_t
+			_data_begin = 0, ///< The beginning of unprocessed data in \ref _buffer.
+			_data_end = 0, ///< The end of valid data in \ref _buffer.
+			/// The maximum number of points that can still be read, limited by the vertex count of PLY files.
+			_remaining = std::numeric_limits<std::size_t>::max(),
+			_num_threads = 1, ///< The number of threads.
+			_chunk_size = 0; ///< The number of bytes parsed by each thread at a time.
+		point_cloud_format _format = point_cloud_format::xyz; ///< The format of the input.
+		bool
+			_input_exhausted = false, ///< Whether the end of the stream has been reached.
+			_failed = false; ///< Whether any malformed data has been encountered.
+
+		/// Returns whether the character is a whitespace that separates columns.
+		[[nodiscard]] constexpr static bool _is_space(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		/// Reads coordinates from consecutive columns starting from \p first.
+		void _set_consecutive_columns(std::size_t first) {
+			_column_dims.assign(first + Dim, _unused_column);
+			for (std::size_t d = 0; d < Dim; ++d) {
+				_column_dims[first + d] = d;
+			}
+		}
+		/// Reads the header of a PLY file and sets up the columns.
+		void _read_ply_header() {
+			constexpr static const char *_names[] = { "x", "y", "z", "w" };
+			static_assert(Dim <= 4, "PLY files can only be read into points with at most 4 dimensions");
+
+			std::string line, word;
+			bool in_vertex = false, ascii = false;
+			std::size_t found = 0;
+			_column_dims.clear();
+			if (!std::getline(*_input, line) || line.compare(0, 3, "ply") != 0) {
+				_fail_header();
+				return;
+			}
+			while (std::getline(*_input, line)) {
+				std::istringstream ss(line);
+				ss >> word;
+				if (word == "end_header") {
+					if (!ascii || found != Dim) {
+						_fail_header();
+					}
+					return;
+				}
+				if (word == "format") {
+					ss >> word;
+					ascii = word == "ascii";
+				} else if (word == "element") {
+					ss >> word;
+					in_vertex = word == "vertex";
+					if (in_vertex) {
+						ss >> _remaining;
+					}
+				} else if (word == "property" && in_vertex) {
+					std::string name;
+					while (ss >> word) { // the last word is the name, regardless of list properties
+						name = word;
+					}
+					std::size_t dim = _unused_column;
+					for (std::size_t d = 0; d < Dim; ++d) {
+						if (name == _names[d]) {
+							dim = d;
+							++found;
+						}
+					}
+					_column_dims.emplace_back(dim);
+				}
+			}
+			_fail_header();
+		}
+		/// Marks the reader as failed due to a malformed or unsupported header.
+		void _fail_header() {
+			_failed = true;
+			_remaining = 0;
+		}
+
+		/// Moves unprocessed data to the front of the buffer and reads more data from the stream. The buffer is
+		/// only enlarged if it contains a single line that does not fit.
+		void _fill() {
+			std::size_t size = _data_end - _data_begin;
+			std::memmove(_buffer.data(), _buffer.data() + _data_begin, size);
+			_data_begin = 0;
+			_data_end = size;
+			if (_data_end == _buffer.size()) {
+				_buffer.resize(_buffer.size() * 2);
+			}
+			_input->read(_buffer.data() + _data_end, static_cast<std::streamsize>(_buffer.size() - _data_end));
+			std::size_t count = static_cast<std::size_t>(_input->gcount());
+			_data_end += count;
+			if (count == 0 || !*_input) {
+				_input_exhausted = true;
+			}
+		}
+
+		/// Returns whether the line contains a vertex.
+		[[nodiscard]] bool _is_vertex_line(const char *beg, const char *end) const {
+			while (beg != end && _is_space(*beg)) {
+				++beg;
+			}
+			if (beg == end) {
+				return false;
+			}
+			switch (_format) {
+			case point_cloud_format::xyz:
+				return *beg != '#';
+			case point_cloud_format::obj:
+				return *beg == 'v' && (beg + 1 == end || _is_space(beg[1]));
+			default:
+				return true;
+			}
+		}
+		/// Parses a vertex line. Returns \p false if the line is malformed.
+		[[nodiscard]] bool _parse_line(const char *beg, const char *end, T (&coords)[Dim]) const {
+			std::size_t parsed = 0;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				if constexpr (std::numeric_limits<T>::has_quiet_NaN) {
+					coords[d] = std::numeric_limits<T>::quiet_NaN();
+				} else {
+					coords[d] = T{};
+				}
+			}
+			for (std::size_t col = 0; col < _column_dims.size(); ++col) {
+				while (beg != end && _is_space(*beg)) {
+					++beg;
+				}
+				const char *token_end = beg;
+				while (token_end != end && !_is_space(*token_end)) {
+					++token_end;
+				}
+				if (std::size_t dim = _column_dims[col]; dim != _unused_column && beg != token_end) {
+					const char *num = *beg == '+' ? beg + 1 : beg; // from_chars() does not accept a leading plus
+					auto [ptr, ec] = std::from_chars(num, token_end, coords[dim]);
+					if (ec == std::errc() && ptr == token_end) {
+						++parsed;
+					}
+				}
+				beg = token_end;
+			}
+			return parsed == Dim;
+		}
+
+		/// Counts the vertex lines in the given range.
+		[[nodiscard]] std::size_t _count_vertices(const char *beg, const char *end) const {
+			std::size_t result = 0;
+			while (beg != end) {
+				const char *line_end = std::find(beg, end, '\n');
+				result += _is_vertex_line(beg, line_end) ? 1 : 0;
+				beg = line_end == end ? end : line_end + 1;
+			}
+			return result;
+		}
+		/// Returns the end of the first \p count vertex lines in the given range.
+		[[nodiscard]] const char *_skip_vertices(const char *beg, const char *end, std::size_t count) const {
+			while (beg != end && count > 0) {
+				const char *line_end = std::find(beg, end, '\n');
+				count -= _is_vertex_line(beg, line_end) ? 1 : 0;
+				beg = line_end == end ? end : line_end + 1;
+			}
+			return beg;
+		}
+		/// Parses all vertex lines in the given range, passing consecutive indices starting from \p first_index
+		/// to \p store. Returns \p false if any line is malformed.
+		template <typename Store> [[nodiscard]] bool _parse_range(
+			const char *beg, const char *end, std::size_t first_index, Store &store
+		) const {
+			bool ok = true;
+			T coords[Dim];
+			while (beg != end) {
+				const char *line_end = std::find(beg, end, '\n');
+				if (_is_vertex_line(beg, line_end)) {
+					ok = _parse_line(beg, line_end, coords) && ok;
+					store(first_index++, coords);
+				}
+				beg = line_end == end ? end : line_end + 1;
+			}
+			return ok;
+		}
+
+		/// Implementation of \ref read().
+		template <typename Store> std::size_t _read(std::size_t max_points, Store &&store) {
+			std::size_t total = 0;
+			std::vector<const char*> bounds;
+			std::vector<std::size_t> counts;
+			std::vector<unsigned char> ok;
+			while (total < max_points && !eof()) {
+				// find the range of complete lines
+				const char *beg = _buffer.data() + _data_begin, *end = _buffer.data() + _data_end;
+				if (!_input_exhausted) {
+					const char *last_newline = end;
+					while (last_newline != beg && last_newline[-1] != '\n') {
+						--last_newline;
+					}
+					if (last_newline == beg || end - beg < static_cast<std::ptrdiff_t>(_chunk_size)) {
+						_fill();
+						continue;
+					}
+					end = last_newline;
+				}
+
+				// split into ranges at line boundaries
+				bounds.assign(1, beg);
+				std::size_t range_size = static_cast<std::size_t>(end - beg) / _num_threads + 1;
+				while (bounds.back() != end) {
+					const char *split = beg + std::min<std::size_t>(range_size * bounds.size(), end - beg);
+					split = std::find(std::max(split, bounds.back()), end, '\n');
+					bounds.emplace_back(split == end ? end : split + 1);
+				}
+				std::size_t num_ranges = bounds.size() - 1;
+				ok.assign(num_ranges, 1);
+
+				// count vertices and compute output offsets, truncating the ranges if there is not enough room
+				counts.assign(num_ranges + 1, 0);
+				parallel::for_each_chunk(
+					num_ranges, num_ranges, 1,
+					[&](std::size_t, std::size_t first, std::size_t last) {
+						for (std::size_t i = first; i < last; ++i) {
+							counts[i + 1] = _count_vertices(bounds[i], bounds[i + 1]);
+						}
+					}
+				);
+				std::size_t capacity = std::min(max_points - total, _remaining);
+				for (std::size_t i = 0; i < num_ranges; ++i) {
+					if (counts[i] + counts[i + 1] >= capacity) {
+						bounds[i + 1] = _skip_vertices(bounds[i], bounds[i + 1], capacity - counts[i]);
+						counts[i + 1] = capacity;
+						num_ranges = i + 1;
+						break;
+					}
+					counts[i + 1] += counts[i];
+				}
+
+				// parse
+				parallel::for_each_chunk(
+					num_ranges, num_ranges, 1,
+					[&](std::size_t, std::size_t first, std::size_t last) {
+						for (std::size_t i = first; i < last; ++i) {
+							ok[i] = _parse_range(bounds[i], bounds[i + 1], total + counts[i], store);
+						}
+					}
+				);
+				std::size_t count = counts[num_ranges];
+				total += count;
+				if (_remaining != std::numeric_limits<std::size_t>::max()) {
+					_remaining -= count;
+				}
+				_data_begin = static_cast<std::size_t>(bounds[num_ranges] - _buffer.data());
+				_failed = _failed || std::find(ok.begin(), ok.begin() + num_ranges, 0) != ok.begin() + num_ranges;
+			}
+			CGMATH_INSTRUMENT_ELEMENTS(parse, total, point<T, Dim>);
+			return total;
+		}
+	};
+
+	/// Reads all points from the given stream.
+	template <typename T, std::size_t Dim> [[nodiscard]] inline std::vector<point<T, Dim>> read_point_cloud(
+		std::istream &in, point_cloud_format fmt, std::size_t num_threads = parallel::default_thread_count()
+	) {
+		return point_cloud_reader<T, Dim>(in, fmt, num_threads).read_all();
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+/// \file
+/// Robust geometric predicates. Determinants are first evaluated in floating point, and are recomputed exactly
+/// using floating-point expansions only when the error bound cannot guarantee the sign. Overflow and underflow
+/// are not handled.
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+#include "point.h"
+
+namespace math::predicates {
+	namespace _details {
+		/// A nonoverlapping expansion: a sum of floating-point components sorted by increasing magnitude, with
+		/// up to \p N components.
+		template <typename T, std::size_t N> struct expansion {
+			T terms[N]; ///< The components.
+			std::size_t size = 0; ///< The number of components.
+
+			/// Returns the component with the largest magnitude, which has the same sign as the sum.
+			[[nodiscard]] T approximate() const {
+				return terms[size - 1];
+			}
+		};
+
+		/// Computes \p a + \p b = \p x + \p y exactly, where \p x is the rounded sum.
+		template <typename T> inline void two_sum(T a, T b, T &x, T &y) {
+			x = a + b;
+			T b_virtual = x - a, a_virtual = x - b_virtual;
+			y = (a - a_virtual) + (b - b_virtual);
+		}
+		/// Computes \p a * \p b = \p x + \p y exactly, where \p x is the rounded product.
+		template <typename T> inline void two_product(T a, T b, T &x, T &y) {
+			x = a * b;
+			y = std::fma(a, b, -x);
+		}
+
+		/// Returns \p a - \p b as an expansion.
+		template <typename T> [[nodiscard]] inline expansion<T, 2> difference(T a, T b) {
+			expansion<T, 2> result;
+			T x, y;
+			two_sum(a, -b, x, y);
+			if (y != T{}) {
+				result.terms[result.size++] = y;
+			}
+			result.terms[result.size++] = x;
+			return result;
+		}
+		/// Returns \p e + \p f, eliminating zero components.
+		template <typename T, std::size_t N, std::size_t M> [[nodiscard]] inline expansion<T, N + M> add(
+			const expansion<T, N> &e, const expansion<T, M> &f
+		) {
+			expansion<T, N + M> result;
+			for (std::size_t i = 0; i < e.size; ++i) {
+				result.terms[i] = e.terms[i];
+			}
+			result.size = e.size;
+			for (std::size_t i = 0; i < f.size; ++i) {
+				expansion<T, N + M> grown;
+				T q = f.terms[i];
+				for (std::size_t j = 0; j < result.size; ++j) {
+					T sum, err;
+					two_sum(q, result.terms[j], sum, err);
+					q = sum;
+					if (err != T{}) {
+						grown.terms[grown.size++] = err;
+					}
+				}
+				if (q != T{} || grown.size == 0) {
+					grown.terms[grown.size++] = q;
+				}
+				result = grown;
+			}
+			return result;
+		}
+		/// Returns -\p e.
+		template <typename T, std::size_t N> [[nodiscard]] inline expansion<T, N> negate(expansion<T, N> e) {
+			for (std::size_t i = 0; i < e.size; ++i) {
+				e.terms[i] = -e.terms[i];
+			}
+			return e;
+		}
+		/// Returns \p e * \p b, eliminating zero components.
+		template <typename T, std::size_t N> [[nodiscard]] inline expansion<T, 2 * N> scale(
+			const expansion<T, N> &e, T b
+		) {
+			expansion<T, 2 * N> result;
+			T q, err;
+			two_product(e.terms[0], b, q, err);
+			if (err != T{}) {
+				result.terms[result.size++] = err;
+			}
+			for (std::size_t i = 1; i < e.size; ++i) {
+				T product1, product0, sum;
+				two_product(e.terms[i], b, product1, product0);
+				two_sum(q, product0, sum, err);
+				if (err != T{}) {
+					result.terms[result.size++] = err;
+				}
+				two_sum(product1, sum, q, err);
+				if (err != T{}) {
+					result.terms[result.size++] = err;
+				}
+			}
+			if (q != T{} || result.size == 0) {
+				result.terms[result.size++] = q;
+			}
+			return result;
+		}
+		/// Returns \p e * \p f.
+		template <typename T, std::size_t N, std::size_t M> [[nodiscard]] inline expansion<T, 2 * N * M> multiply(
+			const expansion<T, N> &e, const expansion<T, M> &f
+		) {
+			expansion<T, 2 * N * M> result;
+			result.terms[result.size++] = T{};
+			for (std::size_t i = 0; i < f.size; ++i) {
+				expansion<T, 2 * N> part = scale(e, f.terms[i]);
+				expansion<T, 2 * N * M + 2 * N> sum = add(result, part);
+				for (std::size_t j = 0; j < sum.size; ++j) {
+					result.terms[j] = sum.terms[j];
+				}
+				result.size = sum.size;
+			}
+			return result;
+		}
+
+		/// Half of the machine epsilon, i.e., the maximum relative error of rounding.
+		template <typename T> constexpr inline T epsilon = std::numeric_limits<T>::epsilon() / static_cast<T>(2);
+	}
+
+	/// Returns a value whose sign is positive if \p a, \p b, and \p c are in counter-clockwise order, negative if
+	/// they are in clockwise order, and zero if they are collinear. The sign is always exact.
+	template <typename T> [[nodiscard]] inline T orient2d(
+		const point<T, 2> &a, const point<T, 2> &b, const point<T, 2> &c
+	) {
+		static_assert(std::is_floating_point_v<T>, "Robust predicates require floating-point coordinates");
+		constexpr T eps = _details::epsilon<T>;
+		constexpr T error_bound = (static_cast<T>(3) + static_cast<T>(16) * eps) * eps;
+
+		T left = (a[0] - c[0]) * (b[1] - c[1]), right = (a[1] - c[1]) * (b[0] - c[0]);
+		T det = left - right;
+		if (std::abs(det) > error_bound * (std::abs(left) + std::abs(right))) {
+			return det;
+		}
+		auto acx = _details::difference(a[0], c[0]), bcy = _details::difference(b[1], c[1]);
+		auto acy = _details::difference(a[1], c[1]), bcx = _details::difference(b[0], c[0]);
+		return _details::add(
+			_details::multiply(acx, bcy), _details::negate(_details::multiply(acy, bcx))
+		).approximate();
+	}
+
+	/// Returns a value whose sign is positive if \p d lies above the plane through \p a, \p b, and \p c, i.e.,
+	/// on the side that \f$ (b - a) \times (c - a) \f$ points to, negative if it lies below the plane, and zero
+	/// if the four points are coplanar. The sign is always exact.
+	template <typename T> [[nodiscard]] inline T orient3d(
+		const point<T, 3> &a, const point<T, 3> &b, const point<T, 3> &c, const point<T, 3> &d
+	) {
+		static_assert(std::is_floating_point_v<T>, "Robust predicates require floating-point coordinates");
+		constexpr T eps = _details::epsilon<T>;
+		constexpr T error_bound = (static_cast<T>(7) + static_cast<T>(56) * eps) * eps;
+
+		vec<T, 3> u = b - a, v = c - a, w = d - a;
+		T vw_x = v[1] * w[2], wv_x = v[2] * w[1];
+		T vw_y = v[2] * w[0], wv_y = v[0] * w[2];
+		T vw_z = v[0] * w[1], wv_z = v[1] * w[0];
+		T det = u[0] * (vw_x - wv_x) + u[1] * (vw_y - wv_y) + u[2] * (vw_z - wv_z);
+		T permanent =
+			std::abs(u[0]) * (std::abs(vw_x) + std::abs(wv_x)) +
+			std::abs(u[1]) * (std::abs(vw_y) + std::abs(wv_y)) +
+			std::abs(u[2]) * (std::abs(vw_z) + std::abs(wv_z));
+		if (std::abs(det) > error_bound * permanent) {
+			return det;
+		}
+
+		_details::expansion<T, 2> eu[3], ev[3], ew[3];
+		for (std::size_t i = 0; i < 3; ++i) {
+			eu[i] = _details::difference(b[i], a[i]);
+			ev[i] = _details::difference(c[i], a[i]);
+			ew[i] = _details::difference(d[i], a[i]);
+		}
+		auto cofactor = [&](std::size_t i, std::size_t j) {
+			return _details::add(
+				_details::multiply(ev[i], ew[j]), _details::negate(_details::multiply(ev[j], ew[i]))
+			);
+		};
+		return _details::add(
+			_details::add(_details::multiply(cofactor(1, 2), eu[0]), _details::multiply(cofactor(2, 0), eu[1])),
+			_details::multiply(cofactor(0, 1), eu[2])
+		).approximate();
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/// \file
+/// Counter-based random number generation.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "array.h"
+
+namespace math::random {
+	/// The Philox4x32-10 counter-based random number generator of Salmon et al. Each 128-bit counter is mapped
+	/// to 128 random bits by a keyed bijection, so any element of a sequence can be computed independently.
+	struct philox4x32 {
+		using counter_type = array<std::uint32_t, 4>; ///< The counter, which is also the type of the output.
+		using key_type = array<std::uint32_t, 2>; ///< The key.
+
+		/// Computes the random bits corresponding to the given counter and key.
+		[[nodiscard]] constexpr static counter_type generate(counter_type ctr, key_type key) {
+			for (std::size_t round = 0; round < _num_rounds; ++round) {
+				std::uint64_t prod0 = static_cast<std::uint64_t>(_multiplier0) * ctr[0];
+				std::uint64_t prod1 = static_cast<std::uint64_t>(_multiplier1) * ctr[2];
+				ctr = counter_type{ {
+					static_cast<std::uint32_t>(prod1 >> 32) ^ ctr[1] ^ key[0],
+					static_cast<std::uint32_t>(prod1),
+					static_cast<std::uint32_t>(prod0 >> 32) ^ ctr[3] ^ key[1],
+					static_cast<std::uint32_t>(prod0)
+				} };
+				key[0] += _weyl0;
+				key[1] += _weyl1;
+			}
+			return ctr;
+		}
+	private:
+		constexpr static std::size_t _num_rounds = 10; ///< The number of rounds.
+		constexpr static std::uint32_t
+			_multiplier0 = 0xD2511F53u, ///< The first multiplier.
+			_multiplier1 = 0xCD9E8D57u, ///< The second multiplier.
+			_weyl0 = 0x9E3779B9u, ///< The first key increment.
+			_weyl1 = 0xBB67AE85u; ///< The second key increment.
+	};
+
+	/// Converts 32 random bits into a \p float in [0, 1).
+	[[nodiscard]] constexpr float to_unit_float(std::uint32_t bits) {
+		return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+	/// Converts 64 random bits into a \p double in [0, 1).
+	[[nodiscard]] constexpr double to_unit_double(std::uint32_t high, std::uint32_t low) {
+		std::uint64_t bits = (static_cast<std::uint64_t>(high) << 32) | low;
+		return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	/// A reproducible stream of random numbers. A stream is identified by a seed and a stream index, so that
+	/// independent streams can be handed to different threads. Sample \p i of a stream is always generated from
+	/// the same counters regardless of how the samples are batched or distributed across threads.
+	struct stream {
+		/// Initializes the stream.
+		constexpr explicit stream(std::uint64_t seed, std::uint64_t stream_index = 0) :
+			_key{ { static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) } },
+			_stream_index(stream_index) {
+		}
+
+		/// Returns \p N uniformly distributed numbers in [0, 1) that belong to the given sample.
+		template <typename T, std::size_t N> constexpr void uniforms(std::uint64_t sample, T (&out)[N]) const {
+			static_assert(std::is_floating_point_v<T>, "Only floating-point types are supported");
+			constexpr std::size_t per_counter = std::is_same_v<T, float> ? 4 : 2;
+			constexpr std::size_t counters_per_sample = (N + per_counter - 1) / per_counter;
+			for (std::size_t c = 0; c < counters_per_sample; ++c) {
+				std::uint64_t index = sample * counters_per_sample + c;
+				philox4x32::counter_type bits = philox4x32::generate(
+					philox4x32::counter_type{ {
+						static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32),
+						static_cast<std::uint32_t>(_stream_index), static_cast<std::uint32_t>(_stream_index >> 32)
+					} },
+					_key
+				);
+				for (std::size_t i = 0; i < per_counter && c * per_counter + i < N; ++i) {
+					if constexpr (std::is_same_v<T, float>) {
+						out[c * per_counter + i] = to_unit_float(bits[i]);
+					} else {
+						out[c * per_counter + i] = static_cast<T>(to_unit_double(bits[2 * i], bits[2 * i + 1]));
+					}
+				}
+			}
+		}
+
+		/// Returns the index of the next sample.
+		[[nodiscard]] constexpr std::uint64_t position() const {
+			return _position;
+		}
+		/// Sets the index of the next sample.
+		constexpr void seek(std::uint64_t pos) {
+			_position = pos;
+		}
+		/// Returns the index of the next sample, and advances the stream by \p count samples.
+		constexpr std::uint64_t advance(std::uint64_t count) {
+			std::uint64_t result = _position;
+			_position += count;
+			return result;
+		}
+	private:
+		philox4x32::key_type _key; ///< The key.
+		std::uint64_t
+			_stream_index = 0, ///< The stream index, used as the upper half of the counter.
+			_position = 0; ///< The index of the next sample.
+	};
+}
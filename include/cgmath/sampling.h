@@ -0,0 +1,156 @@
+#pragma once
+
+/// \file
+/// Bulk sampling of directions and points in shapes.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "vec.h"
+#include "point.h"
+#include "random.h"
+#include "instrument.h"
+
+namespace math::sampling {
+	namespace _details {
+		/// The number of samples generated at a time. Random numbers for a whole block are generated before they
+		/// are transformed, so that both loops consist of independent iterations.
+		constexpr inline std::size_t block_size = 64;
+
+		/// Returns \f$ 2\pi \f$.
+		template <typename T> constexpr inline T two_pi = static_cast<T>(6.283185307179586476925286766559);
+
+		/// Generates \p count samples from the stream using \p N uniform numbers per sample. \p transform is
+		/// called with the uniform numbers of each sample and returns the sample, which is written to \p out.
+		template <
+			typename T, std::size_t N, typename OutIt, typename Transform
+		> inline OutIt generate(random::stream &rng, OutIt out, std::size_t count, Transform &&transform) {
+			CGMATH_INSTRUMENT_ELEMENTS(sample, count, std::invoke_result_t<Transform&, const T (&)[N]>);
+			T uniforms[block_size][N];
+			std::uint64_t first = rng.advance(count);
+			for (std::size_t begin = 0; begin < count; begin += block_size) {
+				std::size_t n = std::min(block_size, count - begin);
+				for (std::size_t i = 0; i < n; ++i) {
+					rng.uniforms(first + begin + i, uniforms[i]);
+				}
+				for (std::size_t i = 0; i < n; ++i) {
+					*out = transform(uniforms[i]);
+					++out;
+				}
+			}
+			return out;
+		}
+
+		/// Returns the cosine and sine of \f$ 2\pi u \f$.
+		template <typename T> inline std::pair<T, T> unit_circle(T u) {
+			T phi = two_pi<T> * u;
+			return { std::cos(phi), std::sin(phi) };
+		}
+	}
+
+	/// Uniformly samples directions in 2D.
+	///
+	/// \return The output iterator after all samples.
+	template <typename T, typename OutIt> inline OutIt unit_circle(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 1>(
+			rng, out, count,
+			[](const T (&u)[1]) {
+				auto [c, s] = _details::unit_circle(u[0]);
+				return unit_vec<T, 2>::from_elements_nocheck(c, s);
+			}
+		);
+	}
+	/// Uniformly samples directions in 3D. The Z coordinate is uniformly distributed in [-1, 1], so the samples
+	/// are constructed directly on the sphere instead of normalizing random vectors.
+	template <typename T, typename OutIt> inline OutIt unit_sphere(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 2>(
+			rng, out, count,
+			[](const T (&u)[2]) {
+				T z = static_cast<T>(1) - static_cast<T>(2) * u[0];
+				T r = std::sqrt(std::max(static_cast<T>(1) - z * z, T{}));
+				auto [c, s] = _details::unit_circle(u[1]);
+				return unit_vec<T, 3>::from_elements_nocheck(r * c, r * s, z);
+			}
+		);
+	}
+	/// Samples directions in the hemisphere around +Z with a density proportional to the cosine of the angle
+	/// between the direction and +Z.
+	template <typename T, typename OutIt> inline OutIt cosine_hemisphere(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 2>(
+			rng, out, count,
+			[](const T (&u)[2]) {
+				T r = std::sqrt(u[0]);
+				auto [c, s] = _details::unit_circle(u[1]);
+				return unit_vec<T, 3>::from_elements_nocheck(r * c, r * s, std::sqrt(static_cast<T>(1) - u[0]));
+			}
+		);
+	}
+
+	/// Uniformly samples points in the unit disk centered at the origin.
+	template <typename T, typename OutIt> inline OutIt unit_disk(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 2>(
+			rng, out, count,
+			[](const T (&u)[2]) {
+				T r = std::sqrt(u[0]);
+				auto [c, s] = _details::unit_circle(u[1]);
+				return point<T, 2>(r * c, r * s);
+			}
+		);
+	}
+	/// Uniformly samples points in the unit ball centered at the origin.
+	template <typename T, typename OutIt> inline OutIt unit_ball(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 3>(
+			rng, out, count,
+			[](const T (&u)[3]) {
+				T z = static_cast<T>(1) - static_cast<T>(2) * u[0];
+				T r = std::sqrt(std::max(static_cast<T>(1) - z * z, T{}));
+				auto [c, s] = _details::unit_circle(u[1]);
+				T radius = std::cbrt(u[2]);
+				return point<T, 3>(radius * r * c, radius * r * s, radius * z);
+			}
+		);
+	}
+
+	/// Uniformly samples barycentric coordinates of points in a triangle.
+	template <typename T, typename OutIt> inline OutIt barycentric(
+		random::stream &rng, OutIt out, std::size_t count
+	) {
+		return _details::generate<T, 2>(
+			rng, out, count,
+			[](const T (&u)[2]) {
+				T su = std::sqrt(u[0]);
+				T b0 = static_cast<T>(1) - su, b1 = u[1] * su;
+				return vec<T, 3>(b0, b1, static_cast<T>(1) - b0 - b1);
+			}
+		);
+	}
+	/// Uniformly samples points in the given triangle. The points are distributed in the same way as those
+	/// computed from \ref barycentric() using the same stream.
+	template <typename T, std::size_t Dim, typename OutIt> inline OutIt triangle(
+		random::stream &rng, const point<T, Dim> &p0, const point<T, Dim> &p1, const point<T, Dim> &p2,
+		OutIt out, std::size_t count
+	) {
+		vec<T, Dim> e1 = p1 - p0, e2 = p2 - p0;
+		return _details::generate<T, 2>(
+			rng, out, count,
+			[&](const T (&u)[2]) {
+				T su = std::sqrt(u[0]);
+				T b1 = u[1] * su, b2 = su - b1;
+				return p0 + (e1 * b1 + e2 * b2);
+			}
+		);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+/// \file
+/// Scalar functions that can be evaluated at compile time.
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "common.h"
+#include "instrument.h"
+
+namespace math::scalar {
+	/// Traits of scalar types. Custom scalar types can specialize this struct to provide their own implementation
+	/// of \ref sqrt() as a static member function.
+	template <typename T> struct traits {
+		/// Whether \ref sqrt() is supported, which also enables norms and normalization of vectors.
+		constexpr static bool has_sqrt = std::is_floating_point_v<T>;
+	};
+
+	namespace _details {
+		/// \p constexpr square root using Newton's method.
+		template <typename T> [[nodiscard]] constexpr T sqrt(T x) {
+			if (!(x >= T{})) { // also catches NaN
+				return std::numeric_limits<T>::quiet_NaN();
+			}
+			if (x == T{} || x == std::numeric_limits<T>::infinity()) {
+				return x;
+			}
+			// scale the input into [1, 4) so that the iteration converges in a fixed number of steps
+			T scale = static_cast<T>(1);
+			while (x >= static_cast<T>(4)) {
+				x *= static_cast<T>(0.25);
+				scale *= static_cast<T>(2);
+			}
+			while (x < static_cast<T>(1)) {
+				x *= static_cast<T>(4);
+				scale *= static_cast<T>(0.5);
+			}
+			T result = (x + static_cast<T>(1)) * static_cast<T>(0.5);
+			for (int i = 0; i < 8; ++i) {
+				result = (result + x / result) * static_cast<T>(0.5);
+			}
+			return result * scale;
+		}
+
+		/// Rounds to the nearest integer, with halfway cases rounded away from zero, without converting to an
+		/// integer type so that large values do not overflow.
+		[[nodiscard]] constexpr long double round(long double x) {
+			long double magnitude = (x < 0.0L ? -x : x) + 0.5L, power = 1.0L, result = 0.0L;
+			if (magnitude < power) {
+				return 0.0L;
+			}
+			while (power * 2.0L <= magnitude) {
+				power *= 2.0L;
+			}
+			for (; power >= 1.0L; power *= 0.5L) { // collect the integral bits from the most significant one
+				if (result + power <= magnitude) {
+					result += power;
+				}
+			}
+			return x < 0.0L ? -result : result;
+		}
+
+		/// \p constexpr sine and cosine using range reduction and Taylor series. Returns the sine if \p Cosine is
+		/// \p false, and the cosine otherwise.
+		template <bool Cosine, typename T> [[nodiscard]] constexpr T sin_cos(T x) {
+			constexpr long double pi = 3.141592653589793238462643383279502884L;
+			long double lx = static_cast<long double>(x);
+			if (!(lx - lx == 0.0L)) { // infinity or NaN
+				return std::numeric_limits<T>::quiet_NaN();
+			}
+			// reduce to [-pi, pi]; large inputs lose precision in each step and may need several
+			while (!(lx >= -pi && lx <= pi)) {
+				lx -= round(lx / (2.0L * pi)) * 2.0L * pi;
+			}
+			long double sqr = lx * lx, term = Cosine ? 1.0L : lx, sum = term;
+			for (int k = 0; k < 20; ++k) {
+				int n = 2 * k + (Cosine ? 1 : 2);
+				term *= -sqr / static_cast<long double>(n * (n + 1));
+				sum += term;
+			}
+			return static_cast<T>(sum);
+		}
+	}
+
+	/// Square root. Uses \p std::sqrt() at runtime, or \p traits<T>::sqrt() for custom scalar types.
+	template <typename T> [[nodiscard]] constexpr T sqrt(T x) {
+		if constexpr (traits<T>::has_sqrt && !std::is_floating_point_v<T>) {
+			return traits<T>::sqrt(x);
+		} else {
+			if (math::_details::is_constant_evaluated()) {
+				return _details::sqrt(x);
+			}
+			CGMATH_INSTRUMENT_CALL(sqrt, T);
+			return std::sqrt(x);
+		}
+	}
+	/// Reciprocal square root.
+	template <typename T> [[nodiscard]] constexpr T rsqrt(T x) {
+		return static_cast<T>(1) / sqrt(x);
+	}
+	/// Sine. Uses \p std::sin() at runtime.
+	template <typename T> [[nodiscard]] constexpr T sin(T x) {
+		if (math::_details::is_constant_evaluated()) {
+			return _details::sin_cos<false>(x);
+		}
+		return std::sin(x);
+	}
+	/// Cosine. Uses \p std::cos() at runtime.
+	template <typename T> [[nodiscard]] constexpr T cos(T x) {
+		if (math::_details::is_constant_evaluated()) {
+			return _details::sin_cos<true>(x);
+		}
+		return std::cos(x);
+	}
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+/// \file
+/// Structure-of-arrays buffers, and kernels that convert between them and arrays of vectors or points.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "array.h"
+#include "instrument.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define CGMATH_SOA_SSE2 // undefined at the end of this file
+#endif
+
+namespace math {
+	/// A non-owning view of \p Dim component arrays of the same length, i.e., a structure-of-arrays buffer. \p T
+	/// can be const-qualified for read-only views.
+	template <typename T, std::size_t Dim> struct soa_span {
+		/// Default constructor.
+		constexpr soa_span() = default;
+		/// Initializes all fields of this struct.
+		constexpr soa_span(const array<T*, Dim> &comps, std::size_t cnt) : components(comps), count(cnt) {
+		}
+		/// Conversion from a non-const view to a const view.
+		template <
+			typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>
+		> constexpr soa_span(const soa_span<U, Dim> &src) : count(src.count) {
+			for (std::size_t i = 0; i < Dim; ++i) {
+				components[i] = src.components[i];
+			}
+		}
+
+		/// Returns the pointer to the first element of the given component.
+		[[nodiscard]] constexpr T *component(std::size_t i) const {
+			return components[i];
+		}
+
+		array<T*, Dim> components; ///< Pointers to the first element of each component.
+		std::size_t count = 0; ///< The number of elements.
+	};
+
+	/// How bulk kernels write their outputs.
+	enum class store_mode : unsigned char {
+		normal, ///< Regular stores.
+		/// Non-temporal stores that bypass caches, for outputs that are too large to stay in cache and that are not
+		/// read back soon. Falls back to regular stores on platforms without SSE2.
+		streaming
+	};
+
+	namespace _details {
+		/// Number of elements converted at once by the conversion kernels. With streaming stores, blocks are
+		/// converted into a local buffer that is then streamed to the output.
+		constexpr inline std::size_t transpose_block_size = 64;
+
+		/// Copies \p count objects using the given \ref store_mode. Streaming stores need to be followed by a call
+		/// to \ref finish_stores().
+		template <typename T> inline void store(T *dst, const T *src, std::size_t count, store_mode mode) {
+#ifdef CGMATH_SOA_SSE2
+			if (mode == store_mode::streaming) {
+				auto *dst_bytes = reinterpret_cast<unsigned char*>(dst);
+				auto *src_bytes = reinterpret_cast<const unsigned char*>(src);
+				std::size_t bytes = count * sizeof(T);
+				std::size_t head = std::min(
+					bytes, static_cast<std::size_t>((16 - reinterpret_cast<std::uintptr_t>(dst_bytes) % 16) % 16)
+				);
+				std::memcpy(dst_bytes, src_bytes, head);
+				std::size_t i = head;
+				for (; i + 16 <= bytes; i += 16) {
+					_mm_stream_si128(
+						reinterpret_cast<__m128i*>(dst_bytes + i),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(src_bytes + i))
+					);
+				}
+				std::memcpy(dst_bytes + i, src_bytes + i, bytes - i);
+				return;
+			}
+#endif
+			static_cast<void>(mode);
+			std::copy(src, src + count, dst);
+		}
+		/// Makes streaming stores visible to other threads.
+		inline void finish_stores([[maybe_unused]] store_mode mode) {
+#ifdef CGMATH_SOA_SSE2
+			if (mode == store_mode::streaming) {
+				_mm_sfence();
+			}
+#endif
+		}
+
+		/// Converts \p out.count elements to a structure-of-arrays buffer, reading element \p i from
+		/// \p in[index(i)]. For small dimensions compilers vectorize the inner loop with shuffles when \p index is
+		/// the identity.
+		template <typename T, std::size_t Dim, typename Elem, typename Index> inline void to_lanes(
+			const Elem *in, Index &&index, const soa_span<T, Dim> &out, store_mode mode
+		) {
+			static_assert(Elem::size() == Dim, "Dimension mismatch");
+			T buffer[Dim][transpose_block_size];
+			T *lanes[Dim];
+			for (std::size_t begin = 0; begin < out.count; begin += transpose_block_size) {
+				std::size_t n = std::min(transpose_block_size, out.count - begin);
+				for (std::size_t d = 0; d < Dim; ++d) {
+					lanes[d] = mode == store_mode::streaming ? buffer[d] : out.components[d] + begin;
+				}
+				for (std::size_t i = 0; i < n; ++i) {
+					const Elem &elem = in[index(begin + i)];
+					for (std::size_t d = 0; d < Dim; ++d) {
+						lanes[d][i] = elem[d];
+					}
+				}
+				if (mode == store_mode::streaming) {
+					for (std::size_t d = 0; d < Dim; ++d) {
+						store(out.components[d] + begin, buffer[d], n, mode);
+					}
+				}
+			}
+			finish_stores(mode);
+		}
+	}
+
+	/// Copies \p out.count vectors or points from \p in into the structure-of-arrays buffer \p out.
+	template <typename T, std::size_t Dim, typename Elem> inline void aos_to_soa(
+		const Elem *in, soa_span<T, Dim> out, store_mode mode = store_mode::normal
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(transpose, out.count, Elem);
+		_details::to_lanes(in, [](std::size_t i) {
+			return i;
+		}, out, mode);
+	}
+	/// Copies the vectors or points in the structure-of-arrays buffer \p in to \p out.
+	template <typename T, std::size_t Dim, typename Elem> inline void soa_to_aos(
+		soa_span<T, Dim> in, Elem *out, store_mode mode = store_mode::normal
+	) {
+		static_assert(Elem::size() == Dim, "Dimension mismatch");
+		CGMATH_INSTRUMENT_ELEMENTS(transpose, in.count, Elem);
+		Elem buffer[_details::transpose_block_size];
+		for (std::size_t begin = 0; begin < in.count; begin += _details::transpose_block_size) {
+			std::size_t n = std::min(_details::transpose_block_size, in.count - begin);
+			Elem *block = mode == store_mode::streaming ? buffer : out + begin;
+			const T *lanes[Dim];
+			for (std::size_t d = 0; d < Dim; ++d) {
+				lanes[d] = in.components[d] + begin;
+			}
+			for (std::size_t i = 0; i < n; ++i) {
+				for (std::size_t d = 0; d < Dim; ++d) {
+					block[i][d] = lanes[d][i];
+				}
+			}
+			if (mode == store_mode::streaming) {
+				_details::store(out + begin, buffer, n, mode);
+			}
+		}
+		_details::finish_stores(mode);
+	}
+
+	/// Copies the vectors or points \p in[indices[i]] into element \p i of the structure-of-arrays buffer \p out
+	/// for all \p i < \p out.count.
+	template <typename T, std::size_t Dim, typename Elem, typename Index> inline void gather(
+		const Elem *in, const Index *indices, soa_span<T, Dim> out, store_mode mode = store_mode::normal
+	) {
+		CGMATH_INSTRUMENT_ELEMENTS(transpose, out.count, Elem);
+		_details::to_lanes(in, [indices](std::size_t i) {
+			return indices[i];
+		}, out, mode);
+	}
+	/// Copies element \p i of the structure-of-arrays buffer \p in to \p out[indices[i]] for all
+	/// \p i < \p in.count. If an index appears multiple times, the last element written to it wins. Since the
+	/// outputs are not contiguous, streaming stores only cover the aligned 16-byte parts of each element.
+	template <typename T, std::size_t Dim, typename Elem, typename Index> inline void scatter(
+		soa_span<T, Dim> in, const Index *indices, Elem *out, store_mode mode = store_mode::normal
+	) {
+		static_assert(Elem::size() == Dim, "Dimension mismatch");
+		CGMATH_INSTRUMENT_ELEMENTS(transpose, in.count, Elem);
+		for (std::size_t i = 0; i < in.count; ++i) {
+			Elem elem;
+			for (std::size_t d = 0; d < Dim; ++d) {
+				elem[d] = in.components[d][i];
+			}
+			_details::store(out + indices[i], &elem, 1, mode);
+		}
+		_details::finish_stores(mode);
+	}
+}
+
+#undef CGMATH_SOA_SSE2
@@ -0,0 +1,167 @@
+#pragma once
+
+/// \file
+/// Tables of directions and points that are generated at compile time.
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "array.h"
+#include "vec.h"
+#include "point.h"
+#include "scalar.h"
+#include "random.h"
+
+namespace math::tables {
+	namespace _details {
+		/// \f$ \pi \f$.
+		template <typename T> constexpr inline T pi = static_cast<T>(3.141592653589793238462643383279502884L);
+
+		/// Returns the i-th point of a Fibonacci sphere with \p N points.
+		template <typename T, std::size_t N> [[nodiscard]] constexpr unit_vec<T, 3> fibonacci_point(std::size_t i) {
+			constexpr T golden_angle = pi<T> * (static_cast<T>(3) - scalar::sqrt(static_cast<T>(5)));
+			T z = static_cast<T>(1) - static_cast<T>(2 * i + 1) / static_cast<T>(N);
+			T r = scalar::sqrt(static_cast<T>(1) - z * z);
+			T phi = golden_angle * static_cast<T>(i);
+			return unit_vec<T, 3>::from_elements_nocheck(r * scalar::cos(phi), r * scalar::sin(phi), z);
+		}
+		/// Implementation of \ref fibonacci_sphere().
+		template <typename T, std::size_t N, std::size_t ...Is> [[nodiscard]] constexpr std::array<
+			unit_vec<T, 3>, N
+		> fibonacci_sphere(std::index_sequence<Is...>) {
+			return { { fibonacci_point<T, N>(Is)... } };
+		}
+
+		/// Converts vectors that are known to be normalized into \ref unit_vec objects.
+		template <typename T, std::size_t N, std::size_t ...Is> [[nodiscard]] constexpr std::array<
+			unit_vec<T, 3>, N
+		> to_unit_vecs(const std::array<vec<T, 3>, N> &vecs, std::index_sequence<Is...>) {
+			return { { unit_vec<T, 3>::from_elements_nocheck(vecs[Is][0], vecs[Is][1], vecs[Is][2])... } };
+		}
+	}
+
+	/// Returns \p N directions that are evenly distributed on the unit sphere, placed on a spiral whose
+	/// consecutive points are separated by the golden angle.
+	template <typename T, std::size_t N> [[nodiscard]] constexpr std::array<unit_vec<T, 3>, N> fibonacci_sphere() {
+		return _details::fibonacci_sphere<T, N>(std::make_index_sequence<N>{});
+	}
+
+	/// Returns \p N points in [0, 1)^2 that approximate a Poisson disk distribution, generated using Mitchell's
+	/// best-candidate algorithm: each point is the candidate among \p Candidates random candidates that is
+	/// farthest from all previous points. Unlike dart throwing, this always produces exactly \p N points.
+	template <
+		typename T, std::size_t N, std::size_t Candidates = 16
+	> [[nodiscard]] constexpr std::array<point<T, 2>, N> poisson_disk(std::uint64_t seed) {
+		std::array<point<T, 2>, N> result{};
+		random::stream rng(seed);
+		for (std::size_t i = 0; i < N; ++i) {
+			T best_dist = -static_cast<T>(1);
+			for (std::size_t c = 0; c < (i == 0 ? 1 : Candidates); ++c) {
+				T u[2]{};
+				rng.uniforms(i * Candidates + c, u);
+				T dist = static_cast<T>(2);
+				for (std::size_t j = 0; j < i; ++j) { // plain arithmetic keeps compile-time evaluation cheap
+					T dx = u[0] - result[j][0], dy = u[1] - result[j][1];
+					T sqr = dx * dx + dy * dy;
+					dist = sqr < dist ? sqr : dist;
+				}
+				if (dist > best_dist) {
+					best_dist = dist;
+					result[i][0] = u[0];
+					result[i][1] = u[1];
+				}
+			}
+		}
+		return result;
+	}
+
+	/// A sphere tessellated by repeatedly subdividing an icosahedron. Triangles are counter-clockwise when
+	/// viewed from outside.
+	template <typename T, std::size_t Subdivisions> struct icosphere {
+	private:
+		/// Returns \f$ 4^{Subdivisions} \f$.
+		[[nodiscard]] constexpr static std::size_t _pow4() {
+			return static_cast<std::size_t>(1) << (2 * Subdivisions);
+		}
+	public:
+		constexpr static std::size_t num_vertices = 10 * _pow4() + 2; ///< The number of vertices.
+		constexpr static std::size_t num_triangles = 20 * _pow4(); ///< The number of triangles.
+
+		/// Generates the sphere.
+		[[nodiscard]] constexpr static icosphere generate() {
+			constexpr T phi = (static_cast<T>(1) + scalar::sqrt(static_cast<T>(5))) / static_cast<T>(2);
+			constexpr T one = static_cast<T>(1);
+			constexpr T base_vertices[12][3] = {
+				{ -one, phi, T{} }, { one, phi, T{} }, { -one, -phi, T{} }, { one, -phi, T{} },
+				{ T{}, -one, phi }, { T{}, one, phi }, { T{}, -one, -phi }, { T{}, one, -phi },
+				{ phi, T{}, -one }, { phi, T{}, one }, { -phi, T{}, -one }, { -phi, T{}, one }
+			};
+			constexpr std::size_t base_triangles[20][3] = {
+				{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+				{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+				{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+				{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+			};
+
+			std::array<vec<T, 3>, num_vertices> vertices{};
+			std::array<array<std::size_t, 3>, num_triangles> triangles{}, next{};
+			std::size_t vertex_count = 12, triangle_count = 20;
+			for (std::size_t i = 0; i < 12; ++i) {
+				vertices[i] = vec<T, 3>(base_vertices[i][0], base_vertices[i][1], base_vertices[i][2])
+					.normalized_nocheck().result;
+			}
+			for (std::size_t i = 0; i < 20; ++i) {
+				for (std::size_t j = 0; j < 3; ++j) {
+					triangles[i][j] = base_triangles[i][j];
+				}
+			}
+
+			for (std::size_t level = 0; level < Subdivisions; ++level) {
+				// midpoints created at this level, keyed by the two endpoints of their edges
+				std::array<array<std::size_t, 3>, num_vertices> edges{};
+				std::size_t edge_count = 0;
+				auto midpoint = [&](std::size_t a, std::size_t b) {
+					if (a > b) {
+						std::size_t tmp = a;
+						a = b;
+						b = tmp;
+					}
+					for (std::size_t i = 0; i < edge_count; ++i) {
+						if (edges[i][0] == a && edges[i][1] == b) {
+							return edges[i][2];
+						}
+					}
+					vertices[vertex_count] = (vertices[a] + vertices[b]).normalized_nocheck().result;
+					edges[edge_count][0] = a;
+					edges[edge_count][1] = b;
+					edges[edge_count][2] = vertex_count;
+					++edge_count;
+					return vertex_count++;
+				};
+				for (std::size_t i = 0; i < triangle_count; ++i) {
+					std::size_t v0 = triangles[i][0], v1 = triangles[i][1], v2 = triangles[i][2];
+					std::size_t m01 = midpoint(v0, v1), m12 = midpoint(v1, v2), m20 = midpoint(v2, v0);
+					std::size_t sub[4][3] = {
+						{ v0, m01, m20 }, { v1, m12, m01 }, { v2, m20, m12 }, { m01, m12, m20 }
+					};
+					for (std::size_t j = 0; j < 4; ++j) {
+						for (std::size_t k = 0; k < 3; ++k) {
+							next[4 * i + j][k] = sub[j][k];
+						}
+					}
+				}
+				triangle_count *= 4;
+				for (std::size_t i = 0; i < triangle_count; ++i) {
+					triangles[i] = next[i];
+				}
+			}
+			return icosphere{
+				_details::to_unit_vecs(vertices, std::make_index_sequence<num_vertices>{}), triangles
+			};
+		}
+
+		std::array<unit_vec<T, 3>, num_vertices> vertices; ///< The vertices.
+		std::array<array<std::size_t, 3>, num_triangles> triangles; ///< Vertex indices of all triangles.
+	};
+}
@@ -17,27 +17,27 @@ namespace math {
 	template <typename, std::size_t> struct vec;
 	template <typename, std::size_t> struct point;
 	template <typename, std::size_t> struct unit_vec;
+	template <typename, std::size_t> struct rigid;
 	namespace _details {
 		/// For use in impl inheritance.
 		template <typename T> struct typed_vec {
 			template <std::size_t Dim> using type = vec<T, Dim>; ///< The corresponding \ref vec type.
 		};
-		/// Shorthand for \ref typed_vec::type.
-		template <typename T> using typed_vec_t = typename typed_vec<T>::type;
 		/// For use in impl inheritance.
 		template <typename T> struct typed_unit_vec {
 			template <std::size_t Dim> using type = unit_vec<T, Dim>; ///< The corresponding \ref unit_vec type.
 		};
-		/// Shorthand for \ref typed_unit_vec::type.
-		template <typename T> using typed_unit_vec_t = typename typed_unit_vec<T>::type;
 	}
 
 	/// Unit vectors.
 	template <typename T, std::size_t Dim> struct unit_vec :
 		public impls::unit_norm_op<unit_vec<T, Dim>>,
-		public impls::swizzle_op<_details::typed_unit_vec_t<T>, Dim, _details::typed_vec_t<T>> {
+		public impls::swizzle_op<
+			_details::typed_unit_vec<T>::template type, Dim, _details::typed_vec<T>::template type
+		> {
 
 		friend vec<T, Dim>;
+		friend rigid<T, Dim>;
 		friend impls::unit_norm_op<unit_vec<T, Dim>>;
 		friend impls::norm_op<vec<T, Dim>, unit_vec<T, Dim>>;
 	public:
@@ -54,6 +54,14 @@ namespace math {
 			return _storage[id];
 		}
 
+		/// Constructs a unit vector from elements that are known to have unit length, without checking or
+		/// normalizing them.
+		template <
+			typename ...Args, typename = std::enable_if_t<sizeof...(Args) == Dim>
+		> [[nodiscard]] inline constexpr static unit_vec from_elements_nocheck(Args &&...args) {
+			return unit_vec(vec<T, Dim>(std::forward<Args>(args)...));
+		}
+
 		/// Negation.
 		[[nodiscard]] constexpr unit_vec operator-() const;
 	private:
@@ -83,7 +91,7 @@ namespace math {
 		};
 		/// \p scalar * \ref unit_vec.
 		template <typename T, std::size_t Dim, typename U> struct scalar_multiplication<U, unit_vec<T, Dim>> {
-			constexpr static bool enabled = std::is_arithmetic_v<U>;
+			constexpr static bool enabled = scalar_type<U>::enabled;
 
 			/// Assumes that the multiplication does not change the value type.
 			using result_type = std::conditional_t<enabled, vec<T, Dim>, void>;
@@ -91,7 +99,7 @@ namespace math {
 		};
 		/// \ref unit_vec / \p scalar.
 		template <typename T, std::size_t Dim, typename U> struct scalar_division<unit_vec<T, Dim>, U> {
-			constexpr static bool enabled = std::is_arithmetic_v<U>;
+			constexpr static bool enabled = scalar_type<U>::enabled;
 
 			/// Assumes that the multiplication does not change the value type.
 			using result_type = std::conditional_t<enabled, vec<T, Dim>, void>;
@@ -100,7 +108,7 @@ namespace math {
 
 		/// \ref unit_vec == \ref unit_vec.
 		template <typename T, std::size_t Dim> struct equality<unit_vec<T, Dim>, unit_vec<T, Dim>> {
-			constexpr static bool enabled = std::is_integral_v<T>; ///< Only enable for integers.
+			constexpr static bool enabled = scalar_type<T>::exact; ///< Only enable for exact types.
 		};
 	}
 
@@ -109,7 +117,7 @@ namespace math {
 		public array<T, Dim>,
 		public impls::dot_op<vec<T, Dim>>,
 		public impls::norm_op<vec<T, Dim>, unit_vec<T, Dim>>,
-		public impls::swizzle_op<typename _details::typed_vec<T>::type, Dim> {
+		public impls::swizzle_op<_details::typed_vec<T>::template type, Dim> {
 
 		friend unit_vec<T, Dim>;
 		friend point<T, Dim>;
@@ -178,7 +186,7 @@ namespace math {
 		};
 		/// \p scalar * \ref vec.
 		template <typename T, std::size_t Dim, typename U> struct scalar_multiplication<U, vec<T, Dim>> {
-			constexpr static bool enabled = std::is_arithmetic_v<U>;
+			constexpr static bool enabled = scalar_type<U>::enabled;
 
 			/// Assumes that the multiplication does not change the value type.
 			using result_type = std::conditional_t<enabled, vec<T, Dim>, void>;
@@ -186,7 +194,7 @@ namespace math {
 		};
 		/// \ref vec / \p scalar.
 		template <typename T, std::size_t Dim, typename U> struct scalar_division<vec<T, Dim>, U> {
-			constexpr static bool enabled = std::is_arithmetic_v<U>;
+			constexpr static bool enabled = scalar_type<U>::enabled;
 
 			/// Assumes that the multiplication does not change the value type.
 			using result_type = std::conditional_t<enabled, vec<T, Dim>, void>;
@@ -195,15 +203,15 @@ namespace math {
 
 		/// \ref vec == \ref vec.
 		template <typename T, std::size_t Dim> struct equality<vec<T, Dim>, vec<T, Dim>> {
-			constexpr static bool enabled = std::is_integral_v<T>; ///< Only enable for integers.
+			constexpr static bool enabled = scalar_type<T>::exact; ///< Only enable for exact types.
 		};
 		/// \ref vec == \ref unit_vec.
 		template <typename T, std::size_t Dim> struct equality<vec<T, Dim>, unit_vec<T, Dim>> {
-			constexpr static bool enabled = std::is_integral_v<T>; ///< Only enable for integers.
+			constexpr static bool enabled = scalar_type<T>::exact; ///< Only enable for exact types.
 		};
 		/// \ref unit_vec == \ref vec.
 		template <typename T, std::size_t Dim> struct equality<unit_vec<T, Dim>, vec<T, Dim>> {
-			constexpr static bool enabled = std::is_integral_v<T>; ///< Only enable for integers.
+			constexpr static bool enabled = scalar_type<T>::exact; ///< Only enable for exact types.
 		};
 	}
 
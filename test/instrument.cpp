@@ -0,0 +1,68 @@
+/// \file
+/// Tests of operation counters. This is compiled separately with \p CGMATH_INSTRUMENT defined.
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cgmath/vec.h>
+#include <cgmath/point.h>
+#include <cgmath/affine.h>
+
+#ifndef CGMATH_INSTRUMENT
+#	error This test must be compiled with CGMATH_INSTRUMENT defined
+#endif
+
+using namespace math;
+
+namespace {
+	/// Returns the counters of the given operation whose type name contains the given string.
+	instrument::counter_entry find_entry(instrument::operation op, const std::string &type) {
+		for (const instrument::counter_entry &entry : instrument::snapshot()) {
+			if (entry.op == op && std::string(entry.type_name).find(type) != std::string::npos) {
+				return entry;
+			}
+		}
+		return instrument::counter_entry();
+	}
+}
+
+// constant evaluation must still work and must not be counted
+constexpr vec3d const_sum = vec3d(1.0, 2.0, 3.0) + vec3d(4.0, 5.0, 6.0);
+
+TEST(instrument, counts) {
+	instrument::reset();
+	vec3f a(1.0f, 2.0f, 3.0f), b(4.0f, 5.0f, 6.0f);
+	for (int i = 0; i < 10; ++i) {
+		a = a + b;
+	}
+	vec3d c(1.0, 2.0, 2.0);
+	EXPECT_DOUBLE_EQ(c.normalized_nocheck().norm, 3.0);
+	std::thread worker(
+		[&]() {
+			vec3f d = a + b;
+			(void)d;
+		}
+	);
+	worker.join();
+
+	EXPECT_EQ(find_entry(instrument::operation::add, "vec<float, 3").calls, 11u);
+	EXPECT_EQ(find_entry(instrument::operation::normalize, "vec<double, 3").calls, 1u);
+	EXPECT_EQ(find_entry(instrument::operation::add, "vec<double, 3").calls, 0u);
+
+	std::vector<point3f> pts(100);
+	transform_points(affine3f::identity(), pts.data(), pts.data(), pts.size());
+	instrument::counter_entry bulk = find_entry(instrument::operation::bulk_transform, "point<float, 3");
+	EXPECT_EQ(bulk.calls, 1u);
+	EXPECT_EQ(bulk.elements, 100u);
+
+	std::ostringstream report;
+	instrument::report(report);
+	EXPECT_NE(report.str().find("operator+ on "), std::string::npos);
+
+	instrument::reset();
+	EXPECT_EQ(find_entry(instrument::operation::add, "vec<float, 3").calls, 0u);
+}
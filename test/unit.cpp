@@ -1,10 +1,27 @@
 /// \file
 /// Unit tests.
 
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <cgmath/vec.h>
 #include <cgmath/point.h>
+#include <cgmath/affine.h>
+#include <cgmath/culling.h>
+#include <cgmath/point_cloud_reader.h>
+#include <cgmath/sampling.h>
+#include <cgmath/tables.h>
+#include <cgmath/hierarchy.h>
+#include <cgmath/grid.h>
+#include <cgmath/curves.h>
+#include <cgmath/convex_hull.h>
+#include <cgmath/fixed.h>
+#include <cgmath/isosurface.h>
 
 using namespace math;
 
@@ -13,7 +30,11 @@ constexpr vec3d a(1.0, 2.0, 3.0);
 constexpr vec3d b(5.0, 4.0, 6.0);
 constexpr vec3d plus = a + b;
 constexpr double a_dot_b = vec3d::dot(a, b);
-/*constexpr double a_sqr_norm = a.squared_norm();*/
+constexpr double a_sqr_norm = a.squared_norm();
+constexpr double a_norm = a.norm();
+constexpr unit_vec3d a_unit = a.normalized_nocheck().result;
+static_assert(a_sqr_norm == 14.0);
+static_assert(a_norm > 3.7416573867 && a_norm < 3.7416573868);
 
 TEST(array, construction) {
 	auto arr1 = array<int, 3>{ { 6, 4, 2 } };
@@ -92,6 +113,1031 @@ TEST(point, arithmetic) {
 	EXPECT_EQ(pt.as_vec(), vec3i(1, 3, 5));
 }
 
+TEST(affine, apply) {
+	affine3d trans = affine3d::translation(vec3d(1.0, 2.0, 3.0)) * affine3d::scaling(vec3d(2.0, 2.0, 2.0));
+	point3d pt = trans * point3d(1.0, 1.0, 1.0);
+	EXPECT_DOUBLE_EQ(pt[0], 3.0);
+	EXPECT_DOUBLE_EQ(pt[1], 4.0);
+	EXPECT_DOUBLE_EQ(pt[2], 5.0);
+	vec3d v = trans * vec3d(1.0, 1.0, 1.0);
+	EXPECT_DOUBLE_EQ(v[0], 2.0);
+	EXPECT_DOUBLE_EQ(v[2], 2.0);
+
+	point3d back = trans.inverse() * pt;
+	EXPECT_NEAR(back[0], 1.0, 1e-12);
+	EXPECT_NEAR(back[1], 1.0, 1e-12);
+	EXPECT_NEAR(back[2], 1.0, 1e-12);
+}
+
+TEST(affine, rigid) {
+	unit_vec3d axis = vec3d(0.0, 0.0, 1.0).normalized_nocheck().result;
+	rigid3d trans = rigid3d::translation(vec3d(1.0, 0.0, 0.0)) * rigid3d::rotation(axis, 1.5707963267948966);
+	unit_vec3d rotated = trans * vec3d(1.0, 0.0, 0.0).normalized_nocheck().result;
+	EXPECT_NEAR(rotated[0], 0.0, 1e-12);
+	EXPECT_NEAR(rotated[1], 1.0, 1e-12);
+	point3d pt = trans * point3d(1.0, 0.0, 0.0);
+	EXPECT_NEAR(pt[0], 1.0, 1e-12);
+	EXPECT_NEAR(pt[1], 1.0, 1e-12);
+
+	point3d back = trans.inverse() * pt;
+	EXPECT_NEAR(back[0], 1.0, 1e-12);
+	EXPECT_NEAR(back[1], 0.0, 1e-12);
+	affine3d general = trans;
+	point3d back2 = general.inverse() * pt;
+	EXPECT_NEAR(back2[0], 1.0, 1e-12);
+	EXPECT_NEAR(back2[1], 0.0, 1e-12);
+}
+
+TEST(affine, bulk) {
+	affine3f trans = affine3f::translation(vec3f(1.0f, 2.0f, 3.0f)) * affine3f::scaling(vec3f(1.0f, 2.0f, 3.0f));
+	std::vector<point3f> pts;
+	for (int i = 0; i < 150; ++i) {
+		pts.emplace_back(static_cast<float>(i), 1.0f, -static_cast<float>(i));
+	}
+	std::vector<point3f> out(pts.size());
+	transform_points(trans, pts.data(), out.data(), pts.size());
+	std::vector<float> xs(pts.size()), ys(pts.size()), zs(pts.size());
+	for (std::size_t i = 0; i < pts.size(); ++i) {
+		xs[i] = pts[i][0];
+		ys[i] = pts[i][1];
+		zs[i] = pts[i][2];
+	}
+	soa_span<float, 3> soa({ { xs.data(), ys.data(), zs.data() } }, pts.size());
+	transform_points(trans, soa, soa);
+	for (std::size_t i = 0; i < pts.size(); ++i) {
+		point3f expected = trans * pts[i];
+		EXPECT_FLOAT_EQ(out[i][0], expected[0]);
+		EXPECT_FLOAT_EQ(out[i][1], expected[1]);
+		EXPECT_FLOAT_EQ(out[i][2], expected[2]);
+		EXPECT_FLOAT_EQ(xs[i], expected[0]);
+		EXPECT_FLOAT_EQ(zs[i], expected[2]);
+	}
+}
+
+TEST(culling, frustum) {
+	auto frust = frustum<float>::perspective(
+		rigid3f::translation(vec3f(0.0f, 0.0f, 10.0f)), 1.5707963f, 1.0f, 1.0f, 100.0f
+	);
+	EXPECT_GT(frust.planes[frustum<float>::near_plane].signed_distance(point3f(0.0f, 0.0f, 0.0f)), 0.0f);
+	EXPECT_LT(frust.planes[frustum<float>::near_plane].signed_distance(point3f(0.0f, 0.0f, 9.5f)), 0.0f);
+	EXPECT_LT(frust.planes[frustum<float>::far_plane].signed_distance(point3f(0.0f, 0.0f, -95.0f)), 0.0f);
+
+	// boxes along the x axis at a depth of 9 to 11: visible iff they overlap -11 < x < 11
+	std::size_t count = 50000;
+	std::vector<float> min_x(count), min_y(count, -1.0f), min_z(count, -1.0f);
+	std::vector<float> max_x(count), max_y(count, 1.0f), max_z(count, 1.0f);
+	for (std::size_t i = 0; i < count; ++i) {
+		min_x[i] = static_cast<float>(i) - 25000.5f;
+		max_x[i] = min_x[i] + 1.0f;
+	}
+	aabb_span<float, 3> boxes{
+		soa_span<const float, 3>({ { min_x.data(), min_y.data(), min_z.data() } }, count),
+		soa_span<const float, 3>({ { max_x.data(), max_y.data(), max_z.data() } }, count)
+	};
+	std::vector<containment> classes(count);
+	std::vector<std::size_t> visible(count), visible_parallel(count);
+	std::size_t num_visible = cull_boxes(frust, boxes, visible.data(), classes.data());
+	std::size_t num_visible_parallel = cull_boxes_parallel(frust, boxes, visible_parallel.data(), nullptr, 4);
+	ASSERT_EQ(num_visible, num_visible_parallel);
+	for (std::size_t i = 0; i < num_visible; ++i) {
+		EXPECT_EQ(visible[i], visible_parallel[i]);
+		EXPECT_NE(classes[visible[i]], containment::outside);
+		EXPECT_GT(max_x[visible[i]], -11.0f);
+		EXPECT_LT(min_x[visible[i]], 11.0f);
+	}
+	EXPECT_EQ(classes[25000], containment::inside);
+	EXPECT_EQ(classes[0], containment::outside);
+	EXPECT_EQ(num_visible, 23u);
+
+	std::vector<std::size_t> visible_no_threads(count);
+	EXPECT_EQ(cull_boxes_parallel(frust, boxes, visible_no_threads.data(), nullptr, 0), num_visible);
+	EXPECT_TRUE(std::equal(visible.begin(), visible.begin() + num_visible, visible_no_threads.begin()));
+}
+
+TEST(point_cloud_reader, formats) {
+	std::ostringstream xyz, obj, ply;
+	std::size_t count = 1000;
+	xyz << "# comment\n";
+	obj << "o cloud\n";
+	ply << "ply\nformat ascii 1.0\nelement vertex " << count << "\n";
+	ply << "property float z\nproperty uchar red\nproperty float x\nproperty float y\n";
+	ply << "element face 1\nproperty list uchar int vertex_indices\nend_header\n";
+	for (std::size_t i = 0; i < count; ++i) {
+		xyz << i << " " << 0.5 * i << "\t-" << i << " 255\r\n";
+		obj << "v " << i << " " << 0.5 * i << " -" << i << "\nvn 0 0 1\n";
+		ply << "-" << i << " 7 " << i << " " << 0.5 * i << "\n";
+	}
+	ply << "3 0 1 2\n";
+
+	auto check = [count](const std::vector<point3d> &pts) {
+		ASSERT_EQ(pts.size(), count);
+		for (std::size_t i = 0; i < count; ++i) {
+			EXPECT_DOUBLE_EQ(pts[i][0], static_cast<double>(i));
+			EXPECT_DOUBLE_EQ(pts[i][1], 0.5 * i);
+			EXPECT_DOUBLE_EQ(pts[i][2], -static_cast<double>(i));
+		}
+	};
+	for (std::size_t threads : { 1, 3 }) {
+		std::istringstream xyz_in(xyz.str()), obj_in(obj.str()), ply_in(ply.str());
+		point_cloud_reader<double, 3> xyz_reader(xyz_in, point_cloud_format::xyz, threads, 64);
+		check(xyz_reader.read_all());
+		EXPECT_FALSE(xyz_reader.failed());
+		point_cloud_reader<double, 3> obj_reader(obj_in, point_cloud_format::obj, threads, 100);
+		check(obj_reader.read_all());
+		EXPECT_FALSE(obj_reader.failed());
+		point_cloud_reader<double, 3> ply_reader(ply_in, point_cloud_format::ply, threads, 200);
+		check(ply_reader.read_all());
+		EXPECT_FALSE(ply_reader.failed());
+	}
+}
+
+TEST(point_cloud_reader, soa) {
+	std::istringstream in("1 2\n3 4\n5 x\n7 8\n9 10");
+	std::vector<float> xs(3), ys(3);
+	point_cloud_reader<float, 2> reader(in, point_cloud_format::xyz, 2);
+	soa_span<float, 2> out({ { xs.data(), ys.data() } }, 3);
+	EXPECT_EQ(reader.read(out), 3u);
+	EXPECT_FLOAT_EQ(xs[2], 5.0f);
+	EXPECT_TRUE(std::isnan(ys[2]));
+	EXPECT_TRUE(reader.failed());
+	EXPECT_EQ(reader.read(out), 2u);
+	EXPECT_FLOAT_EQ(xs[1], 9.0f);
+	EXPECT_FLOAT_EQ(ys[1], 10.0f);
+	EXPECT_TRUE(reader.eof());
+}
+
+TEST(random, philox) {
+	// known answer from the Random123 test vectors
+	auto bits = random::philox4x32::generate({ { 0, 0, 0, 0 } }, { { 0, 0 } });
+	EXPECT_EQ(bits[0], 0x6627e8d5u);
+	EXPECT_EQ(bits[1], 0xe169c58du);
+	EXPECT_EQ(bits[2], 0xbc57ac4cu);
+	EXPECT_EQ(bits[3], 0x9b00dbd8u);
+}
+
+TEST(sampling, reproducible) {
+	random::stream rng1(1234, 5), rng2(1234, 5);
+	std::vector<unit_vec3f> all, split;
+	sampling::unit_sphere<float>(rng1, std::back_inserter(all), 200);
+	sampling::unit_sphere<float>(rng2, std::back_inserter(split), 70);
+	sampling::unit_sphere<float>(rng2, std::back_inserter(split), 130);
+	ASSERT_EQ(all.size(), split.size());
+	vec3d sum;
+	for (std::size_t i = 0; i < all.size(); ++i) {
+		EXPECT_EQ(all[i][0], split[i][0]);
+		EXPECT_EQ(all[i][2], split[i][2]);
+		EXPECT_NEAR(vec3f(all[i]).squared_norm(), 1.0f, 1e-5f);
+		sum += vec3d(all[i][0], all[i][1], all[i][2]);
+	}
+	EXPECT_LT(sum.norm() / all.size(), 0.15);
+}
+
+TEST(sampling, shapes) {
+	random::stream rng(42);
+	std::vector<point3d> ball;
+	sampling::unit_ball<double>(rng, std::back_inserter(ball), 1000);
+	for (const point3d &p : ball) {
+		EXPECT_LE(p.as_vec().squared_norm(), 1.0);
+	}
+	std::vector<unit_vec3d> hemisphere;
+	sampling::cosine_hemisphere<double>(rng, std::back_inserter(hemisphere), 1000);
+	for (const unit_vec3d &v : hemisphere) {
+		EXPECT_GE(v[2], 0.0);
+		EXPECT_NEAR(vec3d(v).squared_norm(), 1.0, 1e-12);
+	}
+
+	point2d a(0.0, 0.0), b(1.0, 0.0), c(0.0, 1.0);
+	random::stream tri_rng(7), bary_rng(7);
+	std::vector<point2d> tri(1000);
+	std::vector<vec3d> bary;
+	sampling::triangle(tri_rng, a, b, c, tri.begin(), tri.size());
+	sampling::barycentric<double>(bary_rng, std::back_inserter(bary), tri.size());
+	for (std::size_t i = 0; i < tri.size(); ++i) {
+		EXPECT_GE(tri[i][0], 0.0);
+		EXPECT_GE(tri[i][1], 0.0);
+		EXPECT_LE(tri[i][0] + tri[i][1], 1.0 + 1e-12);
+		EXPECT_NEAR(tri[i][0], bary[i][1], 1e-12);
+		EXPECT_NEAR(tri[i][1], bary[i][2], 1e-12);
+	}
+}
+
+TEST(scalar, constexpr_functions) {
+	static_assert(scalar::sqrt(16.0) == 4.0);
+	constexpr double sqrt2 = scalar::sqrt(2.0), sin1 = scalar::sin(1.0), cos100 = scalar::cos(100.0f);
+	EXPECT_NEAR(sqrt2, std::sqrt(2.0), 1e-15);
+	EXPECT_NEAR(sin1, std::sin(1.0), 1e-15);
+	EXPECT_NEAR(cos100, std::cos(100.0f), 1e-6);
+	constexpr double sin_million = scalar::sin(1e6), sin_large = scalar::sin(1e25), cos_huge = scalar::cos(1e300);
+	EXPECT_NEAR(sin_million, std::sin(1e6), 1e-9);
+	EXPECT_LE(std::abs(sin_large), 1.0);
+	EXPECT_LE(std::abs(cos_huge), 1.0);
+	EXPECT_NEAR(scalar::rsqrt(4.0f), 0.5f, 1e-7f);
+}
+
+TEST(tables, fibonacci_sphere) {
+	constexpr auto dirs = tables::fibonacci_sphere<float, 256>();
+	static_assert(dirs[0][2] > 0.99f && dirs[255][2] < -0.99f);
+	vec3d sum;
+	for (const unit_vec3f &d : dirs) {
+		EXPECT_NEAR(vec3f(d).squared_norm(), 1.0f, 1e-5f);
+		sum += vec3d(d[0], d[1], d[2]);
+	}
+	EXPECT_LT(sum.norm(), 1.0);
+}
+
+TEST(tables, poisson_disk) {
+	constexpr auto pts = tables::poisson_disk<double, 64>(3);
+	double min_dist = 2.0;
+	for (std::size_t i = 0; i < pts.size(); ++i) {
+		EXPECT_GE(pts[i][0], 0.0);
+		EXPECT_LT(pts[i][1], 1.0);
+		for (std::size_t j = 0; j < i; ++j) {
+			min_dist = std::min(min_dist, (pts[i] - pts[j]).norm());
+		}
+	}
+	EXPECT_GT(min_dist, 0.05);
+}
+
+TEST(tables, icosphere) {
+	constexpr auto sphere = tables::icosphere<double, 2>::generate();
+	static_assert(sphere.vertices.size() == 162 && sphere.triangles.size() == 320);
+	for (const unit_vec3d &v : sphere.vertices) {
+		EXPECT_NEAR(vec3d(v).squared_norm(), 1.0, 1e-12);
+	}
+	for (const auto &tri : sphere.triangles) {
+		vec3d a = sphere.vertices[tri[0]], b = sphere.vertices[tri[1]], c = sphere.vertices[tri[2]];
+		vec3d e1 = b - a, e2 = c - a;
+		vec3d normal(e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]);
+		EXPECT_GT(vec3d::dot(normal, a + b + c), 0.0);
+	}
+}
+
+TEST(transform_hierarchy, update) {
+	transform_hierarchy<double> hierarchy;
+	std::size_t root = hierarchy.add_node();
+	std::size_t child = hierarchy.add_node(root);
+	std::size_t grandchild = hierarchy.add_node(child);
+	std::size_t other = hierarchy.add_node();
+	EXPECT_EQ(hierarchy.level(grandchild), 2u);
+	EXPECT_EQ(hierarchy.update(), 4u);
+
+	hierarchy.set_translation(root, vec3d(1.0, 0.0, 0.0));
+	hierarchy.set_scale(child, vec3d(2.0, 2.0, 2.0));
+	hierarchy.set_translation(grandchild, vec3d(0.0, 1.0, 0.0));
+	hierarchy.set_rotation(
+		grandchild, rigid3d::rotation(vec3d(0.0, 0.0, 1.0).normalized_nocheck().result, 1.5707963267948966)
+	);
+	EXPECT_TRUE(hierarchy.has_pending_changes());
+	EXPECT_EQ(hierarchy.num_pending_changes(), 3u); // nodes changed multiple times are queued once
+	// root, child, and grandchild are updated exactly once; the other root is untouched
+	EXPECT_EQ(hierarchy.update(), 3u);
+	EXPECT_FALSE(hierarchy.has_pending_changes());
+
+	point3d p = hierarchy.world_transform(grandchild) * point3d(1.0, 0.0, 0.0);
+	EXPECT_NEAR(p[0], 1.0, 1e-12);
+	EXPECT_NEAR(p[1], 4.0, 1e-12);
+	EXPECT_NEAR(p[2], 0.0, 1e-12);
+
+	hierarchy.set_translation(child, vec3d(0.0, 0.0, 1.0));
+	point3d q = hierarchy.world_transform(grandchild) * point3d(0.0, 0.0, 0.0);
+	EXPECT_NEAR(q[1], 2.0, 1e-12);
+	EXPECT_NEAR(q[2], 1.0, 1e-12);
+	EXPECT_EQ(hierarchy.update(), 0u);
+	point3d r = hierarchy.world_transform(other) * point3d(0.0, 0.0, 0.0);
+	EXPECT_EQ(r[0], 0.0);
+}
+
+TEST(transform_hierarchy, parallel) {
+	transform_hierarchy<float> hierarchy;
+	std::size_t root = hierarchy.add_node();
+	hierarchy.set_translation(root, vec3f(1.0f, 0.0f, 0.0f));
+	std::vector<std::size_t> leaves;
+	for (std::size_t i = 0; i < 10000; ++i) {
+		std::size_t mid = hierarchy.add_node(root);
+		hierarchy.set_translation(mid, vec3f(0.0f, static_cast<float>(i), 0.0f));
+		leaves.emplace_back(hierarchy.add_node(mid));
+	}
+	EXPECT_EQ(hierarchy.update(4), 20001u);
+	for (std::size_t i = 0; i < leaves.size(); ++i) {
+		vec3f offset = hierarchy.cached_world_transform(leaves[i]).get_translation();
+		EXPECT_EQ(offset[0], 1.0f);
+		EXPECT_EQ(offset[1], static_cast<float>(i));
+	}
+}
+
+TEST(parallel, chunk_count) {
+	EXPECT_EQ(parallel::chunk_count(10, 16, 0), 10u);
+	EXPECT_EQ(parallel::chunk_count(10, 16, 1), 10u);
+	EXPECT_EQ(parallel::chunk_count(10, 4, 3), 4u);
+	EXPECT_EQ(parallel::chunk_count(10, 4, 4), 3u);
+	EXPECT_EQ(parallel::chunk_count(0, 4, 0), 1u);
+	EXPECT_EQ(parallel::chunk_count(10, 0, 1), 1u);
+}
+
+TEST(parallel, thread_pool) {
+	parallel::thread_pool pool;
+	std::vector<int> visits(10000, 0);
+	for (int round = 0; round < 50; ++round) {
+		pool.for_each_chunk(visits.size(), 4, 100, [&](std::size_t, std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i) {
+				++visits[i];
+			}
+		});
+	}
+	EXPECT_EQ(std::count(visits.begin(), visits.end(), 50), static_cast<std::ptrdiff_t>(visits.size()));
+	EXPECT_EQ(pool.num_workers(), 3u); // workers are reused
+
+	// small inputs run on the calling thread
+	parallel::thread_pool copy = pool, inline_pool;
+	std::thread::id caller;
+	inline_pool.for_each_chunk(50, 4, 100, [&](std::size_t, std::size_t, std::size_t) {
+		caller = std::this_thread::get_id();
+	});
+	EXPECT_EQ(caller, std::this_thread::get_id());
+	EXPECT_EQ(inline_pool.num_workers(), 0u);
+	EXPECT_EQ(copy.num_workers(), 0u);
+}
+
+template <typename Layout> void test_grid_layout() {
+	vec3s extents(5u, 11u, 19u);
+	grid<int, 3, Layout> g(extents, -1);
+	EXPECT_EQ(g.size(), 5u * 11u * 19u);
+	EXPECT_GE(g.layout().storage_size(), g.size());
+
+	// every cell is visited exactly once, and maps to a distinct storage location
+	std::vector<int> visits(g.layout().storage_size(), 0);
+	g.for_each(4, [&](const vec3s &coord, int &cell) {
+		cell = static_cast<int>((coord[0] * 11 + coord[1]) * 19 + coord[2]);
+	});
+	for (std::size_t x = 0; x < 5; ++x) {
+		for (std::size_t y = 0; y < 11; ++y) {
+			for (std::size_t z = 0; z < 19; ++z) {
+				vec3s coord(x, y, z);
+				++visits[g.layout().index(coord)];
+				EXPECT_EQ(g[coord], static_cast<int>((x * 11 + y) * 19 + z));
+			}
+		}
+	}
+	EXPECT_EQ(std::count(visits.begin(), visits.end(), 1), static_cast<std::ptrdiff_t>(g.size()));
+
+	EXPECT_EQ(g[point3i(1, 2, 3)], (1 * 11 + 2) * 19 + 3);
+	EXPECT_TRUE(g.contains(point3i(4, 10, 18)));
+	EXPECT_FALSE(g.contains(point3i(-1, 0, 0)));
+	EXPECT_FALSE(g.contains(point3i(0, 11, 0)));
+	EXPECT_EQ(g.at_clamped(point3i(-3, 20, 7)), (0 * 11 + 10) * 19 + 7);
+
+	std::size_t count = 0;
+	g.for_each_neighbor(vec3s(0u, 5u, 18u), 1, [&](const vec3s &coord, int &cell) {
+		EXPECT_EQ(cell, static_cast<int>((coord[0] * 11 + coord[1]) * 19 + coord[2]));
+		++count;
+	});
+	EXPECT_EQ(count, 2u * 3u * 2u);
+
+	// empty grids have no cells or bricks to visit
+	for (const vec3s &empty_extents : { vec3s(4u, 3u, 0u), vec3s(0u, 3u, 5u) }) {
+		grid<int, 3, Layout> empty(empty_extents);
+		std::size_t visited = 0;
+		empty.for_each(1, [&](const vec3s&, int&) {
+			++visited;
+		});
+		empty.for_each_brick(1, [&](const vec3s&, const vec3s&) {
+			++visited;
+		});
+		EXPECT_EQ(empty.size(), 0u);
+		EXPECT_EQ(visited, 0u);
+	}
+}
+
+TEST(grid, layouts) {
+	test_grid_layout<grid_layouts::row_major<3>>();
+	test_grid_layout<grid_layouts::tiled<3, 2>>();
+	test_grid_layout<grid_layouts::morton<3, 2>>();
+
+	EXPECT_EQ(grid_layouts::tiled<2>(vec2s(9u, 8u)).storage_size(), 16u * 8u);
+	grid_layouts::morton<2> morton(vec2s(5u, 3u));
+	EXPECT_EQ(morton.storage_size(), 8u * 4u);
+	// aligned blocks are contiguous
+	EXPECT_EQ(morton.index(vec2s(0u, 0u)), 0u);
+	EXPECT_EQ(morton.index(vec2s(0u, 1u)), 1u);
+	EXPECT_EQ(morton.index(vec2s(1u, 0u)), 2u);
+	EXPECT_EQ(morton.index(vec2s(1u, 1u)), 3u);
+	EXPECT_EQ(morton.index(vec2s(4u, 0u)), 16u);
+}
+
+TEST(grid, stencil) {
+	grid2<float, grid_layouts::tiled<2>> image(vec2s(300u, 200u), 1.0f), blurred(image.extents());
+	blurred.for_each(4, [&](const vec2s &coord, float &out) {
+		float sum = 0.0f;
+		image.for_each_neighbor(coord, 1, [&](const vec2s&, const float &value) {
+			sum += value;
+		});
+		out = sum;
+	});
+	EXPECT_EQ(blurred[vec2s(0u, 0u)], 4.0f);
+	EXPECT_EQ(blurred[vec2s(150u, 199u)], 6.0f);
+	EXPECT_EQ(blurred[vec2s(150u, 100u)], 9.0f);
+}
+
+TEST(curves, bezier) {
+	bezier<double, 2, 3> curve(point2d(0.0, 0.0), point2d(1.0, 2.0), point2d(3.0, 2.0), point2d(4.0, 0.0));
+	// de Casteljau at t = 0.5
+	point2d mid = curve.evaluate(0.5);
+	EXPECT_NEAR(mid[0], 2.0, 1e-12);
+	EXPECT_NEAR(mid[1], 1.5, 1e-12);
+	vec2d tangent = curve.derivative(0.0);
+	EXPECT_NEAR(tangent[0], 3.0, 1e-12);
+	EXPECT_NEAR(tangent[1], 6.0, 1e-12);
+	vec2d second = curve.derivative<2>(0.5);
+	EXPECT_NEAR(second[1], -12.0, 1e-12);
+	EXPECT_EQ(curve.derivative<4>(0.5)[0], 0.0);
+
+	std::vector<double> ts(200);
+	for (std::size_t i = 0; i < ts.size(); ++i) {
+		ts[i] = static_cast<double>(i) / static_cast<double>(ts.size() - 1);
+	}
+	std::vector<point2d> points(ts.size());
+	std::vector<vec2d> tangents(ts.size());
+	curve.evaluate(ts.data(), ts.size(), points.data());
+	curve.derivative(ts.data(), ts.size(), tangents.data());
+	for (std::size_t i = 0; i < ts.size(); ++i) {
+		point2d p = curve.evaluate(ts[i]);
+		vec2d d = curve.derivative(ts[i]);
+		EXPECT_NEAR(points[i][0], p[0], 1e-12);
+		EXPECT_NEAR(points[i][1], p[1], 1e-12);
+		EXPECT_NEAR(tangents[i][0], d[0], 1e-12);
+		EXPECT_NEAR(tangents[i][1], d[1], 1e-12);
+	}
+
+	constexpr bezier<double, 1, 2> quadratic(point<double, 1>(0.0), point<double, 1>(1.0), point<double, 1>(0.0));
+	static_assert(quadratic.evaluate(0.5)[0] == 0.5);
+}
+
+TEST(curves, bspline) {
+	std::vector<point2d> points{
+		point2d(0.0, 0.0), point2d(1.0, 3.0), point2d(2.0, -1.0), point2d(4.0, 2.0), point2d(5.0, 0.0),
+		point2d(7.0, 1.0)
+	};
+	// a clamped spline interpolates the endpoints
+	auto clamped = bspline<double, 2, 3>::clamped(points);
+	EXPECT_NEAR(clamped.evaluate(0.0)[1], 0.0, 1e-12);
+	EXPECT_NEAR(clamped.evaluate(3.0)[0], 7.0, 1e-12);
+	vec2d start_tangent = clamped.derivative(0.0);
+	EXPECT_NEAR(start_tangent[0], 3.0, 1e-12);
+	EXPECT_NEAR(start_tangent[1], 9.0, 1e-12);
+
+	// a uniform spline matches a non-uniform one with integer knots, and the cubic basis at a knot is
+	// (1, 4, 1) / 6
+	uniform_bspline<double, 2, 3> uniform(points);
+	bspline<double, 2, 3> integer_knots(points, { -3.0, -2.0, -1.0, 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 });
+	point2d at_knot = uniform.evaluate(1.0);
+	EXPECT_NEAR(at_knot[0], (1.0 + 4.0 * 2.0 + 4.0) / 6.0, 1e-12);
+	std::vector<double> ts;
+	for (double t = 0.0; t <= 3.0; t += 0.01) {
+		ts.emplace_back(t);
+	}
+	std::vector<point2d> a(ts.size()), b(ts.size());
+	std::vector<vec2d> da(ts.size()), db(ts.size());
+	uniform.evaluate(ts.data(), ts.size(), a.data());
+	integer_knots.evaluate(ts.data(), ts.size(), b.data());
+	uniform.derivative(ts.data(), ts.size(), da.data());
+	integer_knots.derivative(ts.data(), ts.size(), db.data());
+	for (std::size_t i = 0; i < ts.size(); ++i) {
+		for (std::size_t d = 0; d < 2; ++d) {
+			EXPECT_NEAR(a[i][d], b[i][d], 1e-12);
+			EXPECT_NEAR(da[i][d], db[i][d], 1e-12);
+			// central differences
+			double h = 1e-6, t = std::clamp(ts[i], h, 3.0 - h);
+			double numeric = (uniform.evaluate(t + h)[d] - uniform.evaluate(t - h)[d]) / (2.0 * h);
+			EXPECT_NEAR(uniform.derivative(t)[d], numeric, 1e-6);
+		}
+	}
+}
+
+TEST(curves, catmull_rom_flatten) {
+	catmull_rom<float, 3> curve({ point3f(0.0f, 0.0f, 0.0f), point3f(1.0f, 1.0f, 0.0f), point3f(2.0f, 0.0f, 1.0f) });
+	for (std::size_t i = 0; i < 3; ++i) {
+		point3f p = curve.evaluate(static_cast<float>(i));
+		for (std::size_t d = 0; d < 3; ++d) {
+			EXPECT_NEAR(p[d], curve.control_point(i)[d], 1e-6f);
+		}
+	}
+	vec3f tangent = curve.derivative(1.0f);
+	EXPECT_NEAR(tangent[0], 1.0f, 1e-6f);
+	EXPECT_NEAR(tangent[2], 0.5f, 1e-6f);
+
+	std::vector<point3f> coarse, fine;
+	flatten(curve, 0.1f, std::back_inserter(coarse));
+	flatten(curve, 0.001f, std::back_inserter(fine));
+	EXPECT_LT(coarse.size(), fine.size());
+	EXPECT_EQ(fine.front()[0], 0.0f);
+	EXPECT_NEAR(fine.back()[2], 1.0f, 1e-6f);
+	for (std::size_t i = 0; i + 1 < fine.size(); ++i) {
+		EXPECT_LT(fine[i][0], fine[i + 1][0]);
+	}
+
+	bezier<float, 2, 1> line(point2f(0.0f, 0.0f), point2f(1.0f, 1.0f));
+	std::vector<point2f> segment;
+	flatten(line, 0.01f, std::back_inserter(segment));
+	EXPECT_EQ(segment.size(), 2u);
+}
+
+#ifdef __SIZEOF_INT128__
+TEST(predicates, orient2d) {
+	__extension__ typedef __int128 int128;
+	// points near the line y = x that are multiples of 2^-53, compared against exact integer arithmetic
+	constexpr double ulp = 1.0 / 9007199254740992.0;
+	point2d b(12.0, 12.0), c(24.0, 24.0);
+	auto to_int = [](double v) {
+		return static_cast<int128>(v * 9007199254740992.0);
+	};
+	for (int i = 0; i < 64; ++i) {
+		for (int j = 0; j < 64; ++j) {
+			point2d a(0.5 + i * ulp, 0.5 + j * ulp);
+			int128 exact =
+				(to_int(a[0]) - to_int(c[0])) * (to_int(b[1]) - to_int(c[1])) -
+				(to_int(a[1]) - to_int(c[1])) * (to_int(b[0]) - to_int(c[0]));
+			double result = predicates::orient2d(a, b, c);
+			EXPECT_EQ(result > 0.0, exact > 0);
+			EXPECT_EQ(result < 0.0, exact < 0);
+		}
+	}
+}
+#endif
+
+TEST(predicates, orient3d) {
+	// points on the plane x + y + z = 1, which can be represented exactly
+	constexpr double step = 1.0 / 1073741824.0;
+	point3d a(1.0, 0.0, 0.0), b(0.0, 1.0, 0.0), c(0.0, 0.0, 1.0);
+	random::stream rng(3);
+	for (std::size_t i = 0; i < 1000; ++i) {
+		double u[2];
+		rng.uniforms(i, u);
+		double x = std::floor(u[0] * 1e9) * step, y = std::floor(u[1] * 1e9) * step;
+		point3d on(x, y, 1.0 - x - y), above(x, y, 1.0 - x - y + step), below(x, y, 1.0 - x - y - step);
+		EXPECT_EQ(predicates::orient3d(a, b, c, on), 0.0);
+		EXPECT_GT(predicates::orient3d(a, b, c, above), 0.0);
+		EXPECT_LT(predicates::orient3d(a, b, c, below), 0.0);
+		EXPECT_LT(predicates::orient3d(b, a, c, above), 0.0);
+	}
+}
+
+TEST(convex_hull, hull2d) {
+	std::vector<point2d> points{
+		point2d(0.5, 0.5), point2d(1.0, 0.0), point2d(0.0, 0.0), point2d(1.0, 1.0), point2d(0.0, 1.0),
+		point2d(0.5, 0.0), point2d(1.0, 0.25), point2d(1.0, 1.0), point2d(0.25, 0.75)
+	};
+	std::vector<std::size_t> hull = convex_hull(points.data(), points.size());
+	EXPECT_EQ(hull, (std::vector<std::size_t>{ 2, 1, 3, 4 }));
+
+	std::vector<point2d> collinear{ point2d(2.0, 2.0), point2d(0.0, 0.0), point2d(1.0, 1.0) };
+	EXPECT_EQ(convex_hull(collinear.data(), collinear.size()), (std::vector<std::size_t>{ 1, 0 }));
+
+	random::stream rng(11);
+	std::vector<point2d> disk;
+	sampling::unit_disk<double>(rng, std::back_inserter(disk), 200000);
+	std::vector<std::size_t> serial = convex_hull(disk.data(), disk.size(), 1);
+	std::vector<std::size_t> parallel = convex_hull(disk.data(), disk.size(), 4);
+	EXPECT_EQ(serial, parallel);
+	ASSERT_GE(serial.size(), 3u);
+	for (std::size_t i = 0; i < serial.size(); ++i) {
+		const point2d &p0 = disk[serial[i]], &p1 = disk[serial[(i + 1) % serial.size()]];
+		for (std::size_t j = 0; j < disk.size(); j += 97) {
+			EXPECT_GE(predicates::orient2d(p0, p1, disk[j]), 0.0);
+		}
+	}
+}
+
+/// Checks that the triangles form a closed convex surface that contains all points.
+void check_hull3d(const std::vector<point3d> &points, const std::vector<array<std::size_t, 3>> &hull) {
+	std::vector<std::pair<std::size_t, std::size_t>> edges;
+	for (const array<std::size_t, 3> &tri : hull) {
+		for (std::size_t e = 0; e < 3; ++e) {
+			edges.emplace_back(tri[e], tri[(e + 1) % 3]);
+		}
+		for (const point3d &p : points) {
+			EXPECT_LE(predicates::orient3d(points[tri[0]], points[tri[1]], points[tri[2]], p), 0.0);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	EXPECT_EQ(std::adjacent_find(edges.begin(), edges.end()), edges.end());
+	for (const auto &[a, b] : edges) {
+		EXPECT_TRUE(std::binary_search(edges.begin(), edges.end(), std::make_pair(b, a)));
+	}
+}
+
+TEST(convex_hull, hull3d) {
+	std::vector<point3d> cube;
+	for (std::size_t i = 0; i < 8; ++i) {
+		cube.emplace_back(static_cast<double>(i & 1), static_cast<double>((i >> 1) & 1), static_cast<double>(i >> 2));
+	}
+	cube.emplace_back(0.5, 0.5, 0.5);
+	cube.emplace_back(0.5, 0.5, 1.0);
+	cube.emplace_back(1.0, 0.25, 0.75);
+	cube.emplace_back(1.0, 1.0, 1.0);
+	std::vector<array<std::size_t, 3>> hull = convex_hull(cube.data(), cube.size());
+	check_hull3d(cube, hull);
+	std::size_t area = 0;
+	for (const array<std::size_t, 3> &tri : hull) {
+		for (std::size_t v = 0; v < 3; ++v) {
+			EXPECT_LT(tri[v], 8u);
+		}
+		vec3d e1 = cube[tri[1]] - cube[tri[0]], e2 = cube[tri[2]] - cube[tri[0]];
+		vec3d n(e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]);
+		area += static_cast<std::size_t>(n.norm() + 0.5);
+	}
+	EXPECT_EQ(area, 12u); // twice the surface area of the cube
+
+	std::vector<point3d> planar{
+		point3d(0.0, 0.0, 1.0), point3d(1.0, 0.0, 1.0), point3d(0.0, 1.0, 1.0), point3d(1.0, 1.0, 1.0)
+	};
+	EXPECT_TRUE(convex_hull(planar.data(), planar.size()).empty());
+
+	random::stream rng(5);
+	std::vector<point3d> ball;
+	sampling::unit_ball<double>(rng, std::back_inserter(ball), 100000);
+	std::vector<array<std::size_t, 3>> serial = convex_hull(ball.data(), ball.size(), 1);
+	std::vector<array<std::size_t, 3>> parallel = convex_hull(ball.data(), ball.size(), 4);
+	// points are in general position, so both hulls consist of the same faces
+	auto canonical_faces = [](std::vector<array<std::size_t, 3>> faces) {
+		for (array<std::size_t, 3> &tri : faces) {
+			while (tri[0] > tri[1] || tri[0] > tri[2]) {
+				tri = array<std::size_t, 3>{ { tri[1], tri[2], tri[0] } };
+			}
+		}
+		std::sort(faces.begin(), faces.end(), [](const array<std::size_t, 3> &a, const array<std::size_t, 3> &b) {
+			return std::lexicographical_compare(&a[0], &a[0] + 3, &b[0], &b[0] + 3);
+		});
+		return faces;
+	};
+	std::vector<array<std::size_t, 3>> serial_faces = canonical_faces(serial);
+	std::vector<array<std::size_t, 3>> parallel_faces = canonical_faces(parallel);
+	ASSERT_EQ(serial_faces.size(), parallel_faces.size());
+	for (std::size_t i = 0; i < serial_faces.size(); ++i) {
+		EXPECT_TRUE(std::equal(&serial_faces[i][0], &serial_faces[i][0] + 3, &parallel_faces[i][0]));
+	}
+	std::vector<point3d> subset(ball.begin(), ball.begin() + 500);
+	check_hull3d(subset, convex_hull(subset.data(), subset.size()));
+	for (const array<std::size_t, 3> &tri : parallel) {
+		for (std::size_t j = 0; j < ball.size(); j += 499) {
+			EXPECT_LE(predicates::orient3d(ball[tri[0]], ball[tri[1]], ball[tri[2]], ball[j]), 0.0);
+		}
+	}
+}
+
+TEST(fixed, arithmetic) {
+	using fx = fixed16_16;
+	static_assert(fx(3) * fx(0.5) == fx(1.5));
+	static_assert(static_cast<int>(fx(-2.75)) == -2);
+	EXPECT_EQ(fx(1).raw(), 65536);
+	EXPECT_EQ(fx(-0.5).raw(), -32768);
+	EXPECT_EQ((fx(7) / fx(2)).raw(), fx(3.5).raw());
+	EXPECT_EQ((fx::from_raw(1) / fx(3)).raw(), 0); // truncated
+	EXPECT_EQ((fx::from_raw(3) * fx(0.5)).raw(), 2); // ties are rounded up
+	EXPECT_EQ((fx::from_raw(-3) * fx(0.5)).raw(), -1);
+	EXPECT_EQ(fx(5) * 3, fx(15));
+	EXPECT_EQ(2 * fx(1.25), fx(2.5));
+	EXPECT_EQ(fx(5) / 2, fx(2.5));
+	EXPECT_LT(fx(-1), fx(0.5));
+	EXPECT_FLOAT_EQ(static_cast<float>(fx(0.25)), 0.25f);
+
+	EXPECT_EQ(scalar::sqrt(fx(4)), fx(2));
+	EXPECT_EQ(scalar::sqrt(fx(2)).raw(), 92681); // floor(sqrt(2) * 2^16)
+	EXPECT_EQ(scalar::sqrt(fx(-1)), fx(0));
+	EXPECT_EQ(scalar::sqrt(fx(30000)).raw(), 11351168);
+	for (int i = 1; i < 1000; ++i) {
+		fx root = scalar::sqrt(fx::from_raw(i * 4093));
+		std::int64_t next = root.raw() + 1;
+		EXPECT_LE(static_cast<std::int64_t>(root.raw()) * root.raw(), std::int64_t{ i } * 4093 * 65536);
+		EXPECT_GT(next * next, std::int64_t{ i } * 4093 * 65536);
+	}
+}
+
+TEST(fixed, vectors) {
+	using fx = fixed16_16;
+	using vec3x = vec<fx, 3>;
+	vec3x a(fx(1.5), fx(-2), fx(0.25)), b(fx(4), fx(0.5), fx(-8));
+	EXPECT_EQ(a + b, vec3x(fx(5.5), fx(-1.5), fx(-7.75)));
+	EXPECT_EQ(a * fx(2), vec3x(fx(3), fx(-4), fx(0.5)));
+	EXPECT_EQ(fx(2) * a, a * 2);
+	EXPECT_EQ(a / fx(0.5), a * 2);
+	EXPECT_EQ(vec3x::dot(a, b), fx(3));
+	point<fx, 3> p(fx(1), fx(2), fx(3));
+	EXPECT_EQ((p + a) - p, a);
+
+	// products are accumulated at full precision and rounded once
+	vec3x tiny(fx::from_raw(181), fx::from_raw(181), fx::from_raw(181));
+	EXPECT_EQ(tiny.squared_norm().raw(), 1);
+	EXPECT_EQ((tiny[0] * tiny[0]).raw(), 0);
+
+	vec<fx, 2> v(fx(3), fx(-4));
+	EXPECT_EQ(v.norm(), fx(5));
+	auto normalized = v.normalized_nocheck();
+	EXPECT_EQ(normalized.squared_norm, fx(25));
+	EXPECT_EQ(normalized.norm, fx(5));
+	EXPECT_EQ(normalized.result[0].raw(), 39321); // quotients are truncated
+	EXPECT_EQ(normalized.result[1].raw(), -52428);
+	EXPECT_EQ(normalized.result.norm(), fx(1));
+
+#ifdef __SIZEOF_INT128__
+	vec<fixed32_32, 3> big(fixed32_32(3000), fixed32_32(-4000), fixed32_32(0.125));
+	EXPECT_EQ(big.squared_norm(), fixed32_32(25000000) + fixed32_32(0.015625));
+	EXPECT_EQ(big.norm(), fixed32_32::from_raw(21474836486710));
+#endif
+}
+
+TEST(fixed, kernels) {
+	using fx = fixed16_16;
+	using vec3x = vec<fx, 3>;
+	constexpr std::size_t count = 150;
+	random::stream rng(17);
+	std::vector<fx> lanes[6];
+	for (std::size_t i = 0; i < count; ++i) {
+		double u[6];
+		rng.uniforms(i, u);
+		for (std::size_t j = 0; j < 6; ++j) {
+			lanes[j].emplace_back((u[j] - 0.5) * 200.0);
+		}
+	}
+	std::vector<fx> out(count);
+	fixed_kernels::add(lanes[0].data(), lanes[1].data(), out.data(), count);
+	for (std::size_t i = 0; i < count; ++i) {
+		EXPECT_EQ(out[i], lanes[0][i] + lanes[1][i]);
+	}
+	fixed_kernels::subtract(lanes[0].data(), lanes[1].data(), out.data(), count);
+	for (std::size_t i = 0; i < count; ++i) {
+		EXPECT_EQ(out[i], lanes[0][i] - lanes[1][i]);
+	}
+	fixed_kernels::multiply(lanes[0].data(), lanes[1].data(), out.data(), count);
+	for (std::size_t i = 0; i < count; ++i) {
+		EXPECT_EQ(out[i], lanes[0][i] * lanes[1][i]);
+	}
+	fixed_kernels::multiply_add(lanes[0].data(), fx(0.01), lanes[1].data(), out.data(), count);
+	for (std::size_t i = 0; i < count; ++i) {
+		EXPECT_EQ(out[i], lanes[0][i] * fx(0.01) + lanes[1][i]);
+	}
+
+	soa_span<fx, 3> a({ { lanes[0].data(), lanes[1].data(), lanes[2].data() } }, count);
+	soa_span<const fx, 3> b({ { lanes[3].data(), lanes[4].data(), lanes[5].data() } }, count);
+	fixed_kernels::dot(soa_span<const fx, 3>(a), b, out.data());
+	for (std::size_t i = 0; i < count; ++i) {
+		vec3x va(lanes[0][i], lanes[1][i], lanes[2][i]), vb(lanes[3][i], lanes[4][i], lanes[5][i]);
+		EXPECT_EQ(out[i], vec3x::dot(va, vb));
+	}
+	fixed_kernels::squared_norms(a, out.data());
+	for (std::size_t i = 0; i < count; ++i) {
+		EXPECT_EQ(out[i], vec3x(lanes[0][i], lanes[1][i], lanes[2][i]).squared_norm());
+	}
+}
+
+/// Converts vectors or points to a structure-of-arrays buffer and back, and gathers and scatters them.
+template <typename Elem> void test_transpose(store_mode mode) {
+	constexpr std::size_t dim = Elem::size(), count = 150;
+	std::vector<Elem> aos(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t d = 0; d < dim; ++d) {
+			aos[i][d] = static_cast<float>(i * 10 + d);
+		}
+	}
+	std::vector<float> lanes[dim];
+	array<float*, dim> components;
+	for (std::size_t d = 0; d < dim; ++d) {
+		lanes[d].resize(count);
+		components[d] = lanes[d].data();
+	}
+	soa_span<float, dim> soa(components, count);
+	aos_to_soa(aos.data(), soa, mode);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t d = 0; d < dim; ++d) {
+			EXPECT_EQ(lanes[d][i], aos[i][d]);
+		}
+	}
+	std::vector<Elem> back(count);
+	soa_to_aos(soa_span<const float, dim>(soa), back.data(), mode);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t d = 0; d < dim; ++d) {
+			EXPECT_EQ(back[i][d], aos[i][d]);
+		}
+	}
+
+	std::vector<std::uint32_t> indices(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		indices[i] = static_cast<std::uint32_t>((i * 37) % count);
+	}
+	gather(aos.data(), indices.data(), soa, mode);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t d = 0; d < dim; ++d) {
+			EXPECT_EQ(lanes[d][i], aos[indices[i]][d]);
+		}
+	}
+	std::vector<Elem> scattered(count);
+	scatter(soa, indices.data(), scattered.data(), mode);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t d = 0; d < dim; ++d) {
+			EXPECT_EQ(scattered[i][d], aos[i][d]);
+		}
+	}
+}
+TEST(soa, transpose) {
+	for (store_mode mode : { store_mode::normal, store_mode::streaming }) {
+		test_transpose<vec2f>(mode);
+		test_transpose<vec3f>(mode);
+		test_transpose<vec4f>(mode);
+		test_transpose<point2f>(mode);
+		test_transpose<point3f>(mode);
+		test_transpose<point4f>(mode);
+	}
+}
+
+/// Checks that the isosurface is closed and consistently oriented, i.e., that every directed edge appears once
+/// and its reverse also appears, and that no two vertices coincide.
+template <std::size_t Dim> void check_closed_isosurface(const isosurface<float, Dim> &surface) {
+	for (const array<std::uint32_t, Dim> &element : surface.elements) {
+		for (std::size_t i = 0; i < Dim; ++i) {
+			ASSERT_LT(element[i], surface.vertices.size());
+		}
+	}
+	if constexpr (Dim == 2) { // every vertex starts one segment and ends another
+		std::vector<std::size_t> starts(surface.vertices.size(), 0), ends(surface.vertices.size(), 0);
+		for (const array<std::uint32_t, Dim> &element : surface.elements) {
+			EXPECT_NE(element[0], element[1]);
+			++starts[element[0]];
+			++ends[element[1]];
+		}
+		for (std::size_t i = 0; i < surface.vertices.size(); ++i) {
+			EXPECT_EQ(starts[i], 1u);
+			EXPECT_EQ(ends[i], 1u);
+		}
+	} else {
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+		for (const array<std::uint32_t, Dim> &tri : surface.elements) {
+			for (std::size_t i = 0; i < Dim; ++i) {
+				edges.emplace_back(tri[i], tri[(i + 1) % Dim]);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		EXPECT_EQ(std::adjacent_find(edges.begin(), edges.end()), edges.end());
+		for (const auto &[a, b] : edges) {
+			EXPECT_NE(a, b);
+			EXPECT_TRUE(std::binary_search(edges.begin(), edges.end(), std::make_pair(b, a)));
+		}
+	}
+	std::vector<array<float, Dim>> positions;
+	for (const point<float, Dim> &p : surface.vertices) {
+		array<float, Dim> position;
+		for (std::size_t d = 0; d < Dim; ++d) {
+			position[d] = p[d];
+		}
+		positions.emplace_back(position);
+	}
+	auto less = [](const array<float, Dim> &lhs, const array<float, Dim> &rhs) {
+		return std::lexicographical_compare(&lhs[0], &lhs[0] + Dim, &rhs[0], &rhs[0] + Dim);
+	};
+	std::sort(positions.begin(), positions.end(), less);
+	for (std::size_t i = 1; i < positions.size(); ++i) {
+		EXPECT_TRUE(less(positions[i - 1], positions[i]));
+	}
+}
+/// Checks that two isosurfaces are identical.
+template <std::size_t Dim> void check_same_isosurface(
+	const isosurface<float, Dim> &lhs, const isosurface<float, Dim> &rhs
+) {
+	ASSERT_EQ(lhs.vertices.size(), rhs.vertices.size());
+	ASSERT_EQ(lhs.elements.size(), rhs.elements.size());
+	for (std::size_t i = 0; i < lhs.vertices.size(); ++i) {
+		for (std::size_t d = 0; d < Dim; ++d) {
+			EXPECT_EQ(lhs.vertices[i][d], rhs.vertices[i][d]);
+			EXPECT_EQ(lhs.normals[i][d], rhs.normals[i][d]);
+		}
+	}
+	for (std::size_t i = 0; i < lhs.elements.size(); ++i) {
+		for (std::size_t d = 0; d < Dim; ++d) {
+			EXPECT_EQ(lhs.elements[i][d], rhs.elements[i][d]);
+		}
+	}
+}
+/// Returns a field with random values in [-1, 1) surrounded by a border of ones.
+template <std::size_t Dim> grid<float, Dim> random_padded_field(std::size_t size, std::uint64_t seed) {
+	vec<std::size_t, Dim> extents;
+	for (std::size_t d = 0; d < Dim; ++d) {
+		extents[d] = size;
+	}
+	grid<float, Dim> field(extents, 1.0f);
+	random::stream rng(seed);
+	std::uint64_t sample = 0;
+	field.for_each(1, [&](const vec<std::size_t, Dim> &coord, float &value) {
+		for (std::size_t d = 0; d < Dim; ++d) {
+			if (coord[d] == 0 || coord[d] + 1 == size) {
+				return;
+			}
+		}
+		float u[1];
+		rng.uniforms(sample++, u);
+		value = 2.0f * u[0] - 1.0f;
+	});
+	return field;
+}
+
+TEST(isosurface, sphere) {
+	const point3f center(11.5f, 11.7f, 11.3f);
+	const float radius = 8.0f;
+	grid3<float> field(vec3s(24u, 24u, 24u));
+	field.for_each(1, [&](const vec3s &coord, float &value) {
+		point3f p(static_cast<float>(coord[0]), static_cast<float>(coord[1]), static_cast<float>(coord[2]));
+		value = (p - center).norm();
+	});
+
+	isosurface_extractor<float, 3> serial(4), parallel(4);
+	const isosurface<float, 3> &surface = serial.extract(field, radius, 1);
+	check_same_isosurface(surface, parallel.extract(field, radius, 3));
+	isosurface<float, 3> single_slab = isosurface_extractor<float, 3>(100).extract(field, radius);
+	EXPECT_EQ(single_slab.vertices.size(), surface.vertices.size());
+	EXPECT_EQ(single_slab.elements.size(), surface.elements.size());
+
+	check_closed_isosurface(surface);
+	// V - E + F = 2 for a sphere, where E = 3F / 2
+	EXPECT_EQ(2 * surface.vertices.size(), surface.elements.size() + 4);
+	for (std::size_t i = 0; i < surface.vertices.size(); ++i) {
+		vec3f offset = surface.vertices[i] - center;
+		EXPECT_NEAR(offset.norm(), radius, 0.05f);
+		EXPECT_GT(vec3f::dot(offset.normalized_nocheck().result, surface.normals[i]), 0.99f);
+	}
+	for (const array<std::uint32_t, 3> &tri : surface.elements) {
+		vec3f e1 = surface.vertices[tri[1]] - surface.vertices[tri[0]];
+		vec3f e2 = surface.vertices[tri[2]] - surface.vertices[tri[0]];
+		vec3f n(e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]);
+		EXPECT_GT(vec3f::dot(n, surface.normals[tri[0]]), 0.0f);
+	}
+}
+
+TEST(isosurface, incremental) {
+	grid3<float> field = random_padded_field<3>(20, 11);
+	isosurface_extractor<float, 3> incremental(3);
+	incremental.extract(field, 0.0f, 2);
+	for (std::size_t x = 9; x < 12; ++x) {
+		for (std::size_t y = 4; y < 8; ++y) {
+			field[vec3s(x, y, 10u)] = -field[vec3s(x, y, 10u)];
+		}
+	}
+	incremental.mark_dirty(vec3s(9u, 4u, 10u), vec3s(12u, 8u, 11u));
+	const isosurface<float, 3> &updated = incremental.extract(field, 0.0f, 2);
+	check_closed_isosurface(updated);
+	check_same_isosurface(updated, isosurface_extractor<float, 3>(3).extract(field, 0.0f));
+
+	isosurface<float, 3> shifted = isosurface_extractor<float, 3>(3).extract(field, 0.25f);
+	check_same_isosurface(incremental.extract(field, 0.25f, 2), shifted);
+}
+
+TEST(isosurface, ambiguous) {
+	for (std::uint64_t seed = 0; seed < 4; ++seed) {
+		grid3<float> field = random_padded_field<3>(14, seed);
+		isosurface<float, 3> surface = extract_isosurface(field, 0.0f, 3);
+		EXPECT_FALSE(surface.elements.empty());
+		check_closed_isosurface(surface);
+		check_same_isosurface(surface, extract_isosurface(field, 0.0f, 1));
+
+		grid2<float> image = random_padded_field<2>(40, seed);
+		isosurface<float, 2> contours = extract_isosurface(image, 0.0f, 3);
+		EXPECT_FALSE(contours.elements.empty());
+		check_closed_isosurface(contours);
+	}
+}
+
+TEST(isosurface, contours) {
+	const point2f center(10.3f, 9.6f);
+	grid2<float> field(vec2s(21u, 20u));
+	field.for_each(1, [&](const vec2s &coord, float &value) {
+		value = (point2f(static_cast<float>(coord[0]), static_cast<float>(coord[1])) - center).norm();
+	});
+	isosurface<float, 2> contour = extract_isosurface(field, 7.0f, 2);
+	check_closed_isosurface(contour);
+	EXPECT_EQ(contour.vertices.size(), contour.elements.size());
+	for (std::size_t i = 0; i < contour.vertices.size(); ++i) {
+		vec2f offset = contour.vertices[i] - center;
+		EXPECT_NEAR(offset.norm(), 7.0f, 0.05f);
+		EXPECT_GT(vec2f::dot(offset.normalized_nocheck().result, contour.normals[i]), 0.99f);
+	}
+	for (const array<std::uint32_t, 2> &segment : contour.elements) { // larger values on the right
+		vec2f dir = contour.vertices[segment[1]] - contour.vertices[segment[0]];
+		EXPECT_GT(vec2f::dot(vec2f(dir[1], -dir[0]), contour.normals[segment[0]]), 0.0f);
+	}
+}
+
+TEST(instrument, call_sites) {
+	// call sites build whether or not instrumentation is enabled
+	std::size_t count = 0;
+	for (const instrument::counter_entry &entry : instrument::snapshot()) {
+		count += entry.calls > 0 ? 1 : 0;
+	}
+	std::ostringstream report;
+	instrument::report(report);
+	instrument::reset();
+#ifndef CGMATH_INSTRUMENT
+	EXPECT_TRUE(instrument::snapshot().empty());
+	EXPECT_EQ(count, 0u);
+	EXPECT_TRUE(report.str().empty());
+#endif
+}
+
 int main(int argc, char **argv) {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();